@@ -0,0 +1,41 @@
+#include <stddef.h>
+
+#include "AllocCounter.h"
+
+// glibc lets the executable interpose the allocator; forward to the real one.
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+}
+
+static unsigned long sAllocations = 0;
+
+unsigned long nativeAllocationCount()
+{
+  return sAllocations;
+}
+
+extern "C" void *malloc(size_t size)
+{
+  ++sAllocations;
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+  ++sAllocations;
+  return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+  ++sAllocations;
+  return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void *ptr)
+{
+  __libc_free(ptr);
+}
@@ -0,0 +1,8 @@
+#ifndef NATIVE_ALLOCCOUNTER_H
+#define NATIVE_ALLOCCOUNTER_H
+
+// Counts heap allocations (malloc, calloc, realloc and everything built on
+// them, including operator new) made by the host process.
+unsigned long nativeAllocationCount();
+
+#endif // NATIVE_ALLOCCOUNTER_H
@@ -0,0 +1,194 @@
+#include <chrono>
+#include <thread>
+
+#include "Arduino.h"
+
+HardwareSerial Serial;
+
+static bool sVirtualClock = false;
+static uint64_t sVirtualMicros = 1000000; // millis() == 0 means "unset" in places, so start at 1s
+
+static uint64_t realMicros()
+{
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return 1000000 + duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+void nativeSetVirtualClock(bool enabled)
+{
+  if (enabled && !sVirtualClock) {
+    sVirtualMicros = realMicros();
+  }
+  sVirtualClock = enabled;
+}
+
+void nativeAdvanceClock(unsigned long microseconds)
+{
+  sVirtualMicros += microseconds;
+}
+
+void nativeSetClock(uint64_t microseconds)
+{
+  sVirtualMicros = microseconds;
+}
+
+unsigned long nativeRealMicros()
+{
+  return (unsigned long)realMicros();
+}
+
+unsigned long micros()
+{
+  return (unsigned long)(sVirtualClock ? sVirtualMicros : realMicros());
+}
+
+unsigned long millis()
+{
+  return (unsigned long)((sVirtualClock ? sVirtualMicros : realMicros()) / 1000);
+}
+
+void delay(unsigned long ms)
+{
+  if (sVirtualClock) {
+    sVirtualMicros += ms * 1000;
+  } else {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  }
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  if (sVirtualClock) {
+    sVirtualMicros += us;
+  } else {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  }
+}
+
+int analogRead(uint8_t pin)
+{
+  // Floating pins: plenty of noise in the low bits, centered mid-range
+  return 512 + (rand() % 64) - 32;
+}
+
+int digitalRead(uint8_t pin)
+{
+  // Developer board buttons and switches are pulled up
+  return HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {}
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+long random(long howbig)
+{
+  if (howbig == 0) {
+    return 0;
+  }
+  return rand() % howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+  if (howsmall >= howbig) {
+    return howsmall;
+  }
+  return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed)
+{
+  if (seed != 0) {
+    srand(seed);
+  }
+}
+
+/* Serial */
+
+int HardwareSerial::available()
+{
+  return 0;
+}
+
+int HardwareSerial::read()
+{
+  return -1;
+}
+
+void HardwareSerial::flush()
+{
+  if (sink) {
+    fflush(sink);
+  }
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return sink ? fwrite(&c, 1, 1, sink) : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len)
+{
+  return sink ? fwrite(buf, 1, len, sink) : len;
+}
+
+size_t HardwareSerial::print(const char *s)
+{
+  return sink ? fprintf(sink, "%s", s) : strlen(s);
+}
+
+size_t HardwareSerial::print(char c)
+{
+  return write((uint8_t)c);
+}
+
+size_t HardwareSerial::print(int n)
+{
+  return print((long)n);
+}
+
+size_t HardwareSerial::print(unsigned int n)
+{
+  return print((unsigned long)n);
+}
+
+size_t HardwareSerial::print(long n)
+{
+  return sink ? fprintf(sink, "%ld", n) : 0;
+}
+
+size_t HardwareSerial::print(unsigned long n)
+{
+  return sink ? fprintf(sink, "%lu", n) : 0;
+}
+
+size_t HardwareSerial::print(double n)
+{
+  return sink ? fprintf(sink, "%.2f", n) : 0;
+}
+
+size_t HardwareSerial::println(const char *s)
+{
+  return print(s) + println();
+}
+
+size_t HardwareSerial::println(int n)
+{
+  return print(n) + println();
+}
+
+size_t HardwareSerial::println(unsigned long n)
+{
+  return print(n) + println();
+}
+
+size_t HardwareSerial::println()
+{
+  return print("\n");
+}
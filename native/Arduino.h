@@ -0,0 +1,100 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Minimal stand-in for the Arduino core so the scene code can be built and
+// measured on a Linux host. Only what the shared sources actually use is here.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <type_traits>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A9 23
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+
+// Arduino's min/max are macros that accept mixed argument types. Templates keep
+// that behavior without clobbering std::min/std::max for host-only code.
+template <class A, class B>
+static inline typename std::common_type<A, B>::type min(A a, B b) { return (b < a ? b : a); }
+template <class A, class B>
+static inline typename std::common_type<A, B>::type max(A a, B b) { return (a < b ? b : a); }
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+int analogRead(uint8_t pin);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+void pinMode(uint8_t pin, uint8_t mode);
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+class HardwareSerial {
+public:
+  void begin(unsigned long baud) {}
+  operator bool() { return true; }
+  int available();
+  int read();
+  void flush();
+  // Writes to the host never block
+  int availableForWrite() { return 0x7FFF; }
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buf, size_t len);
+
+  size_t print(const char *s);
+  size_t print(char c);
+  size_t print(int n);
+  size_t print(unsigned int n);
+  size_t print(long n);
+  size_t print(unsigned long n);
+  size_t print(double n);
+  size_t println(const char *s);
+  size_t println(int n);
+  size_t println(unsigned long n);
+  size_t println();
+
+  // Host only: where output goes. NULL discards it.
+  FILE *sink = stdout;
+};
+
+extern HardwareSerial Serial;
+
+/* Host extensions */
+
+// With the virtual clock enabled, millis()/micros() only move when the host
+// advances them, so runs are repeatable and can go faster than real time.
+void nativeSetVirtualClock(bool enabled);
+void nativeAdvanceClock(unsigned long microseconds);
+// Put the virtual clock at a fixed time, e.g. so every recording starts alike
+void nativeSetClock(uint64_t microseconds);
+// The real clock, whether or not the virtual one is on. For measuring.
+unsigned long nativeRealMicros();
+
+#endif // NATIVE_ARDUINO_H
@@ -0,0 +1,215 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Capture.h"
+
+static void writeUint32(FILE *file, uint32_t value)
+{
+  for (int i = 0; i < 4; ++i) {
+    fputc((value >> (8 * i)) & 0xFF, file);
+  }
+}
+
+static bool readUint32(FILE *file, uint32_t& value)
+{
+  value = 0;
+  for (int i = 0; i < 4; ++i) {
+    int c = fgetc(file);
+    if (c == EOF) {
+      return false;
+    }
+    value |= (uint32_t)c << (8 * i);
+  }
+  return true;
+}
+
+/* Writing */
+
+CaptureWriter::~CaptureWriter()
+{
+  close();
+}
+
+bool CaptureWriter::open(const char *path, const CaptureHeader& header)
+{
+  close();
+  _file = fopen(path, "wb");
+  if (!_file) {
+    return false;
+  }
+  _byteCount = header.ledCount * 3;
+  _previous = (uint8_t *)calloc(_byteCount ? _byteCount : 1, 1);
+  _lastMicros = 0;
+  _frames = 0;
+
+  fwrite(kCaptureMagic, 1, sizeof(kCaptureMagic), _file);
+  fputc(kCaptureVersion, _file);
+  writeUint32(_file, header.ledCount);
+  writeUint32(_file, header.seed);
+  fputc(header.mode, _file);
+  fwrite(header.modeName, 1, strnlen(header.modeName, sizeof(header.modeName) - 1), _file);
+  fputc('\0', _file);
+  return true;
+}
+
+void CaptureWriter::writeVarint(uint64_t value)
+{
+  while (value >= 0x80) {
+    fputc((value & 0x7F) | 0x80, _file);
+    value >>= 7;
+  }
+  fputc(value, _file);
+}
+
+void CaptureWriter::addFrame(uint64_t micros, const uint8_t *rgb)
+{
+  if (!_file) {
+    return;
+  }
+  writeVarint(micros - _lastMicros);
+  _lastMicros = micros;
+
+  // A run boundary costs two varints, so changed bytes separated by fewer
+  // unchanged ones than that stay in one run
+  static const unsigned int kMinSkip = 3;
+  unsigned int i = 0;
+  while (i < _byteCount) {
+    unsigned int skipStart = i;
+    while (i < _byteCount && rgb[i] == _previous[i]) {
+      ++i;
+    }
+    unsigned int changedStart = i;
+    unsigned int changedEnd = i;
+    while (i < _byteCount) {
+      if (rgb[i] != _previous[i]) {
+        changedEnd = ++i;
+      } else if (i - changedEnd + 1 >= kMinSkip) {
+        break;
+      } else {
+        ++i;
+      }
+    }
+    i = changedEnd;
+    writeVarint(changedStart - skipStart);
+    writeVarint(changedEnd - changedStart);
+    for (unsigned int b = changedStart; b < changedEnd; ++b) {
+      fputc(rgb[b] ^ _previous[b], _file);
+    }
+  }
+  memcpy(_previous, rgb, _byteCount);
+  ++_frames;
+}
+
+void CaptureWriter::close()
+{
+  if (_file) {
+    fclose(_file);
+    _file = NULL;
+  }
+  free(_previous);
+  _previous = NULL;
+}
+
+/* Reading */
+
+CaptureReader::~CaptureReader()
+{
+  if (_file) {
+    fclose(_file);
+  }
+  free(_frame);
+}
+
+bool CaptureReader::open(const char *path)
+{
+  _file = fopen(path, "rb");
+  if (!_file) {
+    _error = strerror(errno);
+    return false;
+  }
+  char magic[sizeof(kCaptureMagic)];
+  if (fread(magic, 1, sizeof(magic), _file) != sizeof(magic) || memcmp(magic, kCaptureMagic, sizeof(magic)) != 0) {
+    _error = "not a capture";
+    return false;
+  }
+  int version = fgetc(_file);
+  if (version != kCaptureVersion) {
+    _error = "unknown capture version";
+    return false;
+  }
+  int mode;
+  if (!readUint32(_file, header.ledCount) || !readUint32(_file, header.seed) || (mode = fgetc(_file)) == EOF) {
+    _error = "header cut short";
+    return false;
+  }
+  header.mode = mode;
+  unsigned int length = 0;
+  int c;
+  while ((c = fgetc(_file)) != EOF && c != '\0') {
+    if (length < sizeof(header.modeName) - 1) {
+      header.modeName[length++] = c;
+    }
+  }
+  header.modeName[length] = '\0';
+  if (c == EOF) {
+    _error = "header cut short";
+    return false;
+  }
+
+  _byteCount = header.ledCount * 3;
+  _frame = (uint8_t *)calloc(_byteCount ? _byteCount : 1, 1);
+  _hasNext = readVarint(_nextDelta);
+  return true;
+}
+
+bool CaptureReader::readVarint(uint64_t& value)
+{
+  value = 0;
+  for (unsigned int shift = 0; shift < 64; shift += 7) {
+    int c = fgetc(_file);
+    if (c == EOF) {
+      return false;
+    }
+    value |= (uint64_t)(c & 0x7F) << shift;
+    if (!(c & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CaptureReader::next()
+{
+  if (!_hasNext || _error) {
+    return false;
+  }
+  micros += _nextDelta;
+  _hasNext = false; // until this frame reads cleanly
+
+  unsigned int i = 0;
+  while (i < _byteCount) {
+    uint64_t skip, changed;
+    if (!readVarint(skip) || !readVarint(changed)) {
+      _error = "frame cut short";
+      return false;
+    }
+    if ((skip == 0 && changed == 0) || skip + changed > _byteCount - i) {
+      _error = "damaged frame";
+      return false;
+    }
+    i += skip;
+    for (unsigned int end = i + changed; i < end; ++i) {
+      int c = fgetc(_file);
+      if (c == EOF) {
+        _error = "frame cut short";
+        return false;
+      }
+      _frame[i] ^= c;
+    }
+  }
+  ++_frames;
+  // The end, if it's between frames
+  _hasNext = readVarint(_nextDelta);
+  return true;
+}
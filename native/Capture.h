@@ -0,0 +1,105 @@
+#ifndef NATIVE_CAPTURE_H
+#define NATIVE_CAPTURE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Frame captures: every frame a mode sent to the strand, with the time it was
+// sent, so two builds' output can be compared pixel for pixel (record.cpp
+// writes them, capdiff.cpp compares them).
+//
+// All integers are little-endian. The file starts with a header:
+//   "LCAP", version (1 byte), LED count (4), seed (4), mode (1),
+//   mode name (NUL-terminated)
+// then one record per frame:
+//   micros since the previous frame (varint)
+//   the frame XORed with the previous one (all black before the first), as
+//   runs of [unchanged byte count (varint)][changed byte count (varint)]
+//   [that many XORed bytes] until the LED count * 3 bytes are covered
+// Varints are 7 bits per byte, low bits first, high bit set on all but the
+// last byte.
+//
+// Frames mostly change a little from the last, so the XOR is mostly zero and
+// the runs skip it.
+
+static const char kCaptureMagic[4] = {'L', 'C', 'A', 'P'};
+static const uint8_t kCaptureVersion = 1;
+
+struct CaptureHeader {
+  uint32_t ledCount;
+  uint32_t seed;
+  uint8_t mode;
+  char modeName[32];
+};
+
+class CaptureWriter {
+public:
+  CaptureWriter() {}
+  ~CaptureWriter();
+
+  // False, with errno set, if the file can't be written
+  bool open(const char *path, const CaptureHeader& header);
+  // rgb is ledCount red, green, blue triples
+  void addFrame(uint64_t micros, const uint8_t *rgb);
+  void close();
+
+  unsigned long frameCount() {
+    return _frames;
+  }
+
+private:
+  FILE *_file = NULL;
+  unsigned int _byteCount = 0;
+  uint8_t *_previous = NULL;
+  uint64_t _lastMicros = 0;
+  unsigned long _frames = 0;
+
+  void writeVarint(uint64_t value);
+};
+
+class CaptureReader {
+public:
+  CaptureReader() {}
+  ~CaptureReader();
+
+  // False if the file can't be read or isn't a capture; see error()
+  bool open(const char *path);
+  // Move on to the next frame. False at the end or on a damaged frame.
+  bool next();
+  // Whether there is a next frame, and its time, without moving to it
+  bool hasNext() {
+    return _hasNext;
+  }
+  uint64_t nextMicros() {
+    return micros + _nextDelta;
+  }
+
+  CaptureHeader header;
+
+  // The current frame, all black before the first
+  uint64_t micros = 0;
+  const uint8_t *rgb() {
+    return _frame;
+  }
+  unsigned long framesRead() {
+    return _frames;
+  }
+
+  // What went wrong, or NULL
+  const char *error() {
+    return _error;
+  }
+
+private:
+  FILE *_file = NULL;
+  unsigned int _byteCount = 0;
+  uint8_t *_frame = NULL;
+  unsigned long _frames = 0;
+  const char *_error = NULL;
+  bool _hasNext = false;
+  uint64_t _nextDelta = 0;
+
+  bool readVarint(uint64_t& value);
+};
+
+#endif // NATIVE_CAPTURE_H
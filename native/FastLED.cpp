@@ -0,0 +1,138 @@
+#include "FastLED.h"
+
+uint16_t rand16seed = 1337;
+
+CFastLED FastLED;
+
+void fill_gradient_RGB(CRGB* leds, uint16_t startpos, CRGB startcolor, uint16_t endpos, CRGB endcolor)
+{
+  // if the points are in the wrong order, straighten them
+  if (endpos < startpos) {
+    uint16_t t = endpos;
+    CRGB tc = endcolor;
+    endcolor = startcolor;
+    endpos = startpos;
+    startpos = t;
+    startcolor = tc;
+  }
+
+  saccum87 rdistance87 = (endcolor.r - startcolor.r) * 128;
+  saccum87 gdistance87 = (endcolor.g - startcolor.g) * 128;
+  saccum87 bdistance87 = (endcolor.b - startcolor.b) * 128;
+
+  uint16_t pixeldistance = endpos - startpos;
+  int16_t divisor = pixeldistance ? pixeldistance : 1;
+
+  saccum87 rdelta87 = rdistance87 / divisor;
+  saccum87 gdelta87 = gdistance87 / divisor;
+  saccum87 bdelta87 = bdistance87 / divisor;
+
+  rdelta87 *= 2;
+  gdelta87 *= 2;
+  bdelta87 *= 2;
+
+  accum88 r88 = startcolor.r << 8;
+  accum88 g88 = startcolor.g << 8;
+  accum88 b88 = startcolor.b << 8;
+  for (uint16_t i = startpos; i <= endpos; ++i) {
+    leds[i] = CRGB(r88 >> 8, g88 >> 8, b88 >> 8);
+    r88 += rdelta87;
+    g88 += gdelta87;
+    b88 += bdelta87;
+  }
+}
+
+CRGBPalette256& CRGBPalette256::operator=(TProgmemRGBGradientPalette_bytes progpal)
+{
+  const uint8_t *progent = progpal;
+  CRGB rgbstart(progent[1], progent[2], progent[3]);
+  int indexstart = 0;
+  while (indexstart < 255) {
+    progent += 4;
+    int indexend = progent[0];
+    CRGB rgbend(progent[1], progent[2], progent[3]);
+    fill_gradient_RGB(entries, indexstart, rgbstart, indexend, rgbend);
+    indexstart = indexend;
+    rgbstart = rgbend;
+  }
+  return *this;
+}
+
+CRGBPalette16& CRGBPalette16::operator=(TProgmemRGBGradientPalette_bytes progpal)
+{
+  const uint8_t *progent = progpal;
+  uint16_t count = 0;
+  do {
+    ++count;
+  } while (progent[(count - 1) * 4] != 255);
+
+  int8_t lastSlotUsed = -1;
+  CRGB rgbstart(progent[1], progent[2], progent[3]);
+  int indexstart = 0;
+  while (indexstart < 255) {
+    progent += 4;
+    int indexend = progent[0];
+    CRGB rgbend(progent[1], progent[2], progent[3]);
+    uint8_t istart8 = indexstart / 16;
+    uint8_t iend8 = indexend / 16;
+    if (count < 16) {
+      if ((istart8 <= lastSlotUsed) && (lastSlotUsed < 15)) {
+        istart8 = lastSlotUsed + 1;
+        if (iend8 < istart8) {
+          iend8 = istart8;
+        }
+      }
+      lastSlotUsed = iend8;
+    }
+    fill_gradient_RGB(entries, istart8, rgbstart, iend8, rgbend);
+    indexstart = indexend;
+    rgbstart = rgbend;
+  }
+  return *this;
+}
+
+static CRGB applyBrightness(uint8_t red, uint8_t green, uint8_t blue, uint8_t brightness)
+{
+  if (brightness != 255) {
+    if (brightness) {
+      ++brightness; // adjust for rounding
+      red = red ? scale8(red, brightness) : 0;
+      green = green ? scale8(green, brightness) : 0;
+      blue = blue ? scale8(blue, brightness) : 0;
+    } else {
+      red = green = blue = 0;
+    }
+  }
+  return CRGB(red, green, blue);
+}
+
+CRGB ColorFromPalette(const CRGBPalette16& pal, uint8_t index, uint8_t brightness, TBlendType blendType)
+{
+  uint8_t hi4 = index >> 4;
+  uint8_t lo4 = index & 0x0F;
+
+  const CRGB *entry = &(pal.entries[0]) + hi4;
+  uint8_t red1 = entry->red;
+  uint8_t green1 = entry->green;
+  uint8_t blue1 = entry->blue;
+
+  if (lo4 && blendType != NOBLEND) {
+    if (hi4 == 15) {
+      entry = &(pal.entries[0]);
+    } else {
+      ++entry;
+    }
+    uint8_t f2 = lo4 << 4;
+    uint8_t f1 = 255 - f2;
+    red1 = scale8(red1, f1) + scale8(entry->red, f2);
+    green1 = scale8(green1, f1) + scale8(entry->green, f2);
+    blue1 = scale8(blue1, f1) + scale8(entry->blue, f2);
+  }
+  return applyBrightness(red1, green1, blue1, brightness);
+}
+
+CRGB ColorFromPalette(const CRGBPalette256& pal, uint8_t index, uint8_t brightness, TBlendType blendType)
+{
+  const CRGB& entry = pal.entries[index];
+  return applyBrightness(entry.red, entry.green, entry.blue, brightness);
+}
@@ -0,0 +1,294 @@
+#ifndef NATIVE_FASTLED_H
+#define NATIVE_FASTLED_H
+
+// Minimal stand-in for FastLED so the scene code can be built and measured on a
+// Linux host. The 8-bit math, random16 and gradient palette expansion follow
+// the portable C implementations in FastLED so host output matches the boards.
+
+#include "Arduino.h"
+
+typedef uint8_t fract8;
+typedef uint16_t accum88;
+typedef int16_t saccum87;
+
+#define FL_PROGMEM PROGMEM
+#define FASTLED_RAND16_2053  ((uint16_t)(2053))
+#define FASTLED_RAND16_13849 ((uint16_t)(13849))
+
+/* lib8tion */
+
+static inline uint8_t scale8(uint8_t i, fract8 scale)
+{
+  return (((uint16_t)i) * (1 + (uint16_t)(scale))) >> 8;
+}
+
+static inline uint8_t scale8_video(uint8_t i, fract8 scale)
+{
+  return (((int)i * (int)scale) >> 8) + ((i && scale) ? 1 : 0);
+}
+
+static inline uint16_t scale16by8(uint16_t i, fract8 scale)
+{
+  return (i * (1 + ((uint16_t)scale))) >> 8;
+}
+
+static inline uint8_t qadd8(uint8_t i, uint8_t j)
+{
+  unsigned int t = i + j;
+  return t > 255 ? 255 : t;
+}
+
+static inline uint8_t qsub8(uint8_t i, uint8_t j)
+{
+  int t = i - j;
+  return t < 0 ? 0 : t;
+}
+
+static inline uint8_t addmod8(uint8_t a, uint8_t b, uint8_t m)
+{
+  a += b;
+  while (a >= m) a -= m;
+  return a;
+}
+
+static inline uint8_t dim8_raw(uint8_t x)
+{
+  return scale8(x, x);
+}
+
+static inline uint8_t lerp8by8(uint8_t a, uint8_t b, fract8 frac)
+{
+  if (b > a) {
+    return a + scale8(b - a, frac);
+  } else {
+    return a - scale8(a - b, frac);
+  }
+}
+
+static inline uint8_t ease8InOutQuad(uint8_t i)
+{
+  uint8_t j = i;
+  if (j & 0x80) {
+    j = 255 - j;
+  }
+  uint8_t jj = scale8(j, j);
+  uint8_t jj2 = jj << 1;
+  if (i & 0x80) {
+    jj2 = 255 - jj2;
+  }
+  return jj2;
+}
+
+extern uint16_t rand16seed;
+
+static inline uint8_t random8()
+{
+  rand16seed = (rand16seed * FASTLED_RAND16_2053) + FASTLED_RAND16_13849;
+  return (uint8_t)(((uint8_t)(rand16seed & 0xFF)) + ((uint8_t)(rand16seed >> 8)));
+}
+
+static inline uint8_t random8(uint8_t lim)
+{
+  return (random8() * lim) >> 8;
+}
+
+static inline uint16_t random16()
+{
+  rand16seed = (rand16seed * FASTLED_RAND16_2053) + FASTLED_RAND16_13849;
+  return rand16seed;
+}
+
+static inline uint16_t random16(uint16_t lim)
+{
+  return ((uint32_t)random16() * lim) >> 16;
+}
+
+static inline void random16_set_seed(uint16_t seed)
+{
+  rand16seed = seed;
+}
+
+static inline void random16_add_entropy(uint16_t entropy)
+{
+  rand16seed += entropy;
+}
+
+/* Colors */
+
+struct CRGB {
+  union {
+    struct {
+      union { uint8_t r; uint8_t red; };
+      union { uint8_t g; uint8_t green; };
+      union { uint8_t b; uint8_t blue; };
+    };
+    uint8_t raw[3];
+  };
+
+  typedef enum {
+    Black = 0x000000,
+    Red = 0xFF0000,
+    Green = 0x008000,
+    Blue = 0x0000FF,
+    White = 0xFFFFFF,
+  } HTMLColorCode;
+
+  CRGB() : r(0), g(0), b(0) {}
+  CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+  CRGB(uint32_t colorcode) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+  CRGB(HTMLColorCode colorcode) : CRGB((uint32_t)colorcode) {}
+
+  uint8_t& operator[](uint8_t x) { return raw[x]; }
+  const uint8_t& operator[](uint8_t x) const { return raw[x]; }
+
+  CRGB& nscale8(uint8_t scaledown) {
+    r = scale8(r, scaledown);
+    g = scale8(g, scaledown);
+    b = scale8(b, scaledown);
+    return *this;
+  }
+};
+
+static inline bool operator==(const CRGB& lhs, const CRGB& rhs)
+{
+  return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b;
+}
+
+static inline bool operator!=(const CRGB& lhs, const CRGB& rhs)
+{
+  return !(lhs == rhs);
+}
+
+// A view onto a run of pixels; (a, b) with a > b walks backwards.
+class CPixelView {
+public:
+  CRGB *leds;
+  int len;
+  int8_t dir;
+
+  CPixelView(CRGB *leds, int start, int end) : leds(leds + start), len((end - start) + ((end >= start) ? 1 : -1)), dir(end >= start ? 1 : -1) {}
+
+  CRGB& operator[](int x) { return dir < 0 ? leds[-x] : leds[x]; }
+  CPixelView operator()(int start, int end) { return CPixelView(dir < 0 ? leds - start : leds + start, 0, (end - start)); }
+
+  CPixelView& operator=(const CPixelView& rhs) {
+    for (int i = 0; i < abs(len) && i < abs(rhs.len); ++i) {
+      (*this)[i] = const_cast<CPixelView&>(rhs)[i];
+    }
+    return *this;
+  }
+  operator CRGB*() { return leds; }
+};
+
+template <int SIZE>
+class CRGBArray : public CPixelView {
+  CRGB rawleds[SIZE];
+public:
+  CRGBArray() : CPixelView(rawleds, 0, SIZE - 1) {}
+  using CPixelView::operator=;
+};
+
+void fill_gradient_RGB(CRGB* leds, uint16_t startpos, CRGB startcolor, uint16_t endpos, CRGB endcolor);
+
+/* Palettes */
+
+typedef uint8_t TProgmemRGBGradientPalette_byte;
+typedef const TProgmemRGBGradientPalette_byte *TProgmemRGBGradientPalette_bytes;
+typedef TProgmemRGBGradientPalette_bytes TProgmemRGBGradientPalettePtr;
+
+#define DEFINE_GRADIENT_PALETTE(X) \
+  extern const TProgmemRGBGradientPalette_byte X[] FL_PROGMEM =
+
+typedef enum { NOBLEND = 0, LINEARBLEND = 1 } TBlendType;
+
+class CRGBPalette16 {
+public:
+  CRGB entries[16];
+  CRGBPalette16() {}
+  CRGBPalette16(TProgmemRGBGradientPalette_bytes progpal) { *this = progpal; }
+  CRGBPalette16& operator=(TProgmemRGBGradientPalette_bytes progpal);
+};
+
+class CRGBPalette256 {
+public:
+  CRGB entries[256];
+  CRGBPalette256() {}
+  CRGBPalette256(TProgmemRGBGradientPalette_bytes progpal) { *this = progpal; }
+  CRGBPalette256& operator=(TProgmemRGBGradientPalette_bytes progpal);
+};
+
+CRGB ColorFromPalette(const CRGBPalette16& pal, uint8_t index, uint8_t brightness = 255, TBlendType blendType = LINEARBLEND);
+CRGB ColorFromPalette(const CRGBPalette256& pal, uint8_t index, uint8_t brightness = 255, TBlendType blendType = LINEARBLEND);
+
+/* Timers */
+
+class CEveryNMillis {
+public:
+  uint32_t mPrevTrigger;
+  uint32_t mPeriod;
+  CEveryNMillis(uint32_t period) : mPeriod(period) { mPrevTrigger = millis(); }
+  operator bool() {
+    uint32_t now = millis();
+    if (now - mPrevTrigger >= mPeriod) {
+      mPrevTrigger = now;
+      return true;
+    }
+    return false;
+  }
+};
+
+#define EVERY_N_MILLISECONDS(N) static CEveryNMillis PER_LINE_TIMER(N); if (PER_LINE_TIMER)
+#define EVERY_N_SECONDS(N) static CEveryNMillis PER_LINE_TIMER((N) * 1000); if (PER_LINE_TIMER)
+#define PER_LINE_TIMER CONCAT_TIMER(perLineTimer, __LINE__)
+#define CONCAT_TIMER(a, b) CONCAT_TIMER_(a, b)
+#define CONCAT_TIMER_(a, b) a##b
+
+/* Controllers */
+
+enum EOrder { RGB = 0012, RBG = 0021, GRB = 0102, GBR = 0120, BRG = 0201, BGR = 0210 };
+
+template <uint8_t DATA_PIN, EOrder RGB_ORDER = RGB> class WS2811 {};
+template <uint8_t DATA_PIN, EOrder RGB_ORDER = RGB> class WS2812B {};
+
+class CLEDController {
+public:
+  CRGB *leds = NULL;
+  int count = 0;
+  CLEDController *next = NULL;
+  void setLeds(CRGB *data, int nLeds) {
+    leds = data;
+    count = nLeds;
+  }
+};
+
+class CFastLED {
+  CLEDController controllers[8];
+  int controllerCount = 0;
+  uint8_t brightness = 0xFF;
+public:
+  // Host only: number of show() calls
+  unsigned long showCount = 0;
+
+  template <template <uint8_t DATA_PIN, EOrder RGB_ORDER> class CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+  CLEDController& addLeds(CRGB *data, int nLedsOrOffset, int nLedsIfOffset = 0) {
+    CLEDController& c = controllers[controllerCount < 7 ? controllerCount++ : 7];
+    if (nLedsIfOffset > 0) {
+      c.setLeds(data + nLedsOrOffset, nLedsIfOffset);
+    } else {
+      c.setLeds(data, nLedsOrOffset);
+    }
+    return c;
+  }
+
+  void setBrightness(uint8_t scale) { brightness = scale; }
+  uint8_t getBrightness() { return brightness; }
+  void setCorrection(uint32_t correction) {}
+  void show() { ++showCount; }
+  int count() { return controllerCount; }
+  CLEDController& operator[](int x) { return controllers[x]; }
+};
+
+extern CFastLED FastLED;
+#define LEDS FastLED
+
+#endif // NATIVE_FASTLED_H
@@ -0,0 +1,75 @@
+#include <chrono>
+
+#include "MockOutput.h"
+
+using namespace std::chrono;
+
+MockWireOutput::MockWireOutput(unsigned int count, bool doubleBuffered) : OutputDriver(count, doubleBuffered), _doubleBuffered(doubleBuffered)
+{
+  addStrand(0, count);
+  if (_doubleBuffered) {
+    _worker = std::thread(&MockWireOutput::run, this);
+  }
+}
+
+MockWireOutput::~MockWireOutput()
+{
+  if (_doubleBuffered) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _quit = true;
+    }
+    _changed.notify_all();
+    _worker.join();
+  }
+}
+
+bool MockWireOutput::isSending()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _sending;
+}
+
+void MockWireOutput::send()
+{
+  ++framesSent;
+  if (!_doubleBuffered) {
+    steady_clock::time_point start = steady_clock::now();
+    std::this_thread::sleep_until(start + wireTime());
+    blockedNanos += duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _sending = true;
+  }
+  _changed.notify_all();
+}
+
+void MockWireOutput::waitUntilSent()
+{
+  if (!_doubleBuffered) {
+    return;
+  }
+  steady_clock::time_point start = steady_clock::now();
+  std::unique_lock<std::mutex> lock(_mutex);
+  _changed.wait(lock, [this]() { return !_sending; });
+  blockedNanos += duration_cast<nanoseconds>(steady_clock::now() - start).count();
+}
+
+void MockWireOutput::run()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _changed.wait(lock, [this]() { return _sending || _quit; });
+    if (_quit) {
+      break;
+    }
+    // _front is only read while sending, and present() won't touch it until done
+    lock.unlock();
+    std::this_thread::sleep_for(wireTime());
+    lock.lock();
+    _sending = false;
+    _changed.notify_all();
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef NATIVE_MOCKOUTPUT_H
+#define NATIVE_MOCKOUTPUT_H
+
+#include <stdint.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "FastLED.h"
+#include "Output.h"
+
+// Host stand-in for a strand that takes real time to send: a WS2811 frame is
+// 30us per pixel (24 bits at 800kHz) plus a 50us latch. Double-buffered, a
+// worker thread sleeps out the wire time so the scene can compute the next
+// frame meanwhile; single-buffered, present() sleeps it out itself, like a
+// bit-banged driver holding the CPU.
+class MockWireOutput : public OutputDriver {
+public:
+  MockWireOutput(unsigned int count, bool doubleBuffered);
+  ~MockWireOutput();
+
+  bool isSending();
+  bool isDoubleBuffered() {
+    return _doubleBuffered;
+  }
+
+  static const unsigned long kMicrosPerPixel = 30;
+  static const unsigned long kLatchMicros = 50;
+
+  // Wall time present() kept the caller waiting for the wire, in total
+  uint64_t blockedNanos = 0;
+  unsigned long framesSent = 0;
+
+protected:
+  void send();
+  void waitUntilSent();
+
+private:
+  const bool _doubleBuffered;
+  std::thread _worker;
+  std::mutex _mutex;
+  std::condition_variable _changed;
+  bool _sending = false;
+  bool _quit = false;
+
+  std::chrono::microseconds wireTime() const {
+    return std::chrono::microseconds(count * kMicrosPerPixel + kLatchMicros);
+  }
+  void run();
+};
+
+#endif // NATIVE_MOCKOUTPUT_H
@@ -0,0 +1,29 @@
+#ifndef NATIVE_MODENAMES_H
+#define NATIVE_MODENAMES_H
+
+#include "Pattern.h"
+
+// Every mode, in the order the host tools run them, by the name they take
+// on the command line
+struct ModeName {
+  Mode mode;
+  const char *name;
+};
+
+static const ModeName kModeNames[] = {
+  {ModeWaves, "Waves"},
+  {ModeFire, "Fire"},
+  {ModeBlueFire, "BlueFire"},
+  {ModeGreenFire, "GreenFire"},
+  {ModePinkFire, "PinkFire"},
+  {ModeLightningBugs, "LightningBugs"},
+  {ModeParity, "Parity"},
+  {ModeInterferingWaves, "InterferingWaves"},
+  {ModeRainbow, "Rainbow"},
+  {ModeAccumulator, "Accumulator"},
+  {ModeTwinkle, "Twinkle"},
+  {ModeBounce, "Bounce"},
+  {ModeBoomResponder, "BoomResponder"},
+};
+
+#endif // NATIVE_MODENAMES_H
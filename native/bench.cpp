@@ -0,0 +1,150 @@
+// Per-mode frame-time benchmark for the host build.
+//
+// Runs every mode through Scene::tick() on a virtual 120fps clock and reports
+// wall-clock ns/frame, ns/LED and heap allocations per frame, plus the heap
+// allocations made by setMode() itself, the mode's peak use of the mode state
+// arena, and how many frames and pixels the strand update skipped because
+// nothing changed. LED_COUNT is a compile-time constant, so CMake builds one
+// binary per strand length.
+//
+// usage: lights_bench_<count> [-f frames] [-m mode] [-o double|single] [-p] [-s seed] [-v] [-k]
+//   -o sends frames to a mock strand that takes as long as a real one (see
+//      MockOutput.h), double- or single-buffered, and adds the time each frame
+//      spent waiting on it. Frames are then paced in real time, so runs are slow.
+//   -p prints the per-stage profile (Profiler.h) after the run. Needs a build
+//      with -DLIGHTS_PROFILING=ON.
+//   -s seeds every random number (randomSeedAll in Random.h). The seed is
+//      fixed at 1 otherwise, so runs with the same arguments draw the same.
+//   -k runs the color and random number kernel micro-benchmarks instead (see kernels.cpp)
+
+#include <chrono>
+
+#include "Config.h"
+#include "Utilities.h"
+#include "Color.h"
+#include "Light.h"
+#include "Scene.h"
+#include "AllocCounter.h"
+#include "MockOutput.h"
+#include "kernels.h"
+#include "ModeNames.h"
+
+static const unsigned long kFrameMicros = 1000000 / 120;
+static const unsigned int kWarmupFrames = 120;
+
+static uint64_t nowNanos()
+{
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char **argv)
+{
+  unsigned int frames = 1200;
+  const char *onlyMode = NULL;
+  bool verbose = false;
+#if PROFILING
+  bool profile = false;
+#endif
+  uint32_t seed = 1; // fixed, so runs can be compared
+  MockWireOutput *wire = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+      frames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+      onlyMode = argv[++i];
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      ++i;
+      if (strcmp(argv[i], "double") != 0 && strcmp(argv[i], "single") != 0) {
+        fprintf(stderr, "-o takes double or single\n");
+        return 1;
+      }
+      wire = new MockWireOutput(LED_COUNT, strcmp(argv[i], "double") == 0);
+    } else if (strcmp(argv[i], "-p") == 0) {
+#if PROFILING
+      profile = true;
+#else
+      fprintf(stderr, "-p needs a build with -DLIGHTS_PROFILING=ON\n");
+      return 1;
+#endif
+    } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "-v") == 0) {
+      verbose = true;
+    } else if (strcmp(argv[i], "-k") == 0) {
+      runKernelBenchmarks();
+      return 0;
+    } else {
+      fprintf(stderr, "usage: %s [-f frames] [-m mode] [-o double|single] [-p] [-s seed] [-v] [-k]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (frames == 0) {
+    frames = 1;
+  }
+
+  Serial.sink = (verbose ? stderr : NULL);
+  nativeSetVirtualClock(true);
+  randomSeedAll(seed);
+
+  Scene *scene = new Scene(LED_COUNT, wire);
+
+  printf("%-18s %6s %7s %12s %9s %13s %12s %12s %12s %10s\n", "mode", "leds", "frames", "ns/frame", "ns/led", "allocs/frame", "allocs/mode",
+         "arena bytes", "skip frames%", "skip px%");
+  if (wire) {
+    printf("  output: mock wire, %s-buffered, %lu us/frame on the wire\n", (wire->isDoubleBuffered() ? "double" : "single"),
+           LED_COUNT * MockWireOutput::kMicrosPerPixel + MockWireOutput::kLatchMicros);
+  }
+  for (unsigned int m = 0; m < ARRAY_SIZE(kModeNames); ++m) {
+    const ModeName& bench = kModeNames[m];
+    if ((onlyMode && strcmp(onlyMode, bench.name) != 0) || !scene->hasPattern(bench.mode)) {
+      continue;
+    }
+    unsigned long allocationsBefore = nativeAllocationCount();
+    scene->setMode(bench.mode);
+    unsigned long modeAllocations = nativeAllocationCount() - allocationsBefore;
+    for (unsigned int f = 0; f < kWarmupFrames; ++f) {
+      nativeAdvanceClock(kFrameMicros);
+      scene->tick();
+      logDrain(kFrameMicros);
+      scene->idle(kFrameMicros);
+    }
+
+    uint64_t elapsed = 0;
+    allocationsBefore = nativeAllocationCount();
+    StrandStats statsBefore = scene->strandStats();
+    uint64_t blockedBefore = (wire ? wire->blockedNanos : 0);
+    for (unsigned int f = 0; f < frames; ++f) {
+      nativeAdvanceClock(kFrameMicros);
+      uint64_t start = nowNanos();
+      scene->tick();
+      elapsed += nowNanos() - start;
+      logDrain(kFrameMicros);
+      scene->idle(kFrameMicros);
+    }
+    unsigned long allocations = nativeAllocationCount() - allocationsBefore;
+    const StrandStats& stats = scene->strandStats();
+    double framesSkipped = 100.0 * (stats.framesSkipped - statsBefore.framesSkipped) / (stats.frames - statsBefore.frames);
+    double pixelsSkipped = 100.0 * (stats.pixelsSkipped - statsBefore.pixelsSkipped) / ((stats.frames - statsBefore.frames) * (double)LED_COUNT);
+
+    double nsPerFrame = elapsed / (double)frames;
+    printf("%-18s %6u %7u %12.0f %9.2f %13.2f %12lu %12lu %12.1f %10.1f\n", bench.name, (unsigned)LED_COUNT, frames,
+           nsPerFrame, nsPerFrame / LED_COUNT, allocations / (double)frames, modeAllocations,
+           (unsigned long)scene->modeArenaHighWater(bench.mode), framesSkipped, pixelsSkipped);
+    if (wire) {
+      printf("  %.0f ns/frame waiting on output\n", (wire->blockedNanos - blockedBefore) / (double)frames);
+    }
+  }
+
+#if PROFILING
+  if (profile) {
+    logFlush();
+    Serial.sink = stdout;
+    printf("\n");
+    gProfiler.report();
+  }
+#endif
+
+  delete scene;
+  return 0;
+}
@@ -0,0 +1,130 @@
+// Compares two captures (Capture.h) frame by frame, e.g. a golden capture
+// recorded before an optimization against one recorded after it.
+//
+// Frames are matched up by time, not by count: a build that skips sending a
+// frame nothing changed in is compared on its last frame sent. Reports the
+// largest difference in any one channel of any pixel and where it first
+// happened, and how many frames differed at all.
+//
+// usage: lights_capdiff [-t tolerance] [-q] golden.lcap new.lcap
+//   Exits 0 if no channel differs by more than the tolerance (0 by default),
+//   1 if one does, and 2 if either file can't be read or they don't match up.
+//   -q prints nothing, for scripts.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Capture.h"
+
+struct FrameError {
+  unsigned int maxError;
+  unsigned int pixel; // where it first reached maxError
+  unsigned int channel;
+};
+
+static FrameError compareFrames(const uint8_t *a, const uint8_t *b, unsigned int ledCount)
+{
+  FrameError error = {0, 0, 0};
+  for (unsigned int i = 0; i < 3 * ledCount; ++i) {
+    unsigned int difference = (a[i] > b[i] ? a[i] - b[i] : b[i] - a[i]);
+    if (difference > error.maxError) {
+      error.maxError = difference;
+      error.pixel = i / 3;
+      error.channel = i % 3;
+    }
+  }
+  return error;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned int tolerance = 0;
+  bool quiet = false;
+  const char *paths[2];
+  unsigned int pathCount = 0;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      tolerance = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-q") == 0) {
+      quiet = true;
+    } else if (argv[i][0] != '-' && pathCount < 2) {
+      paths[pathCount++] = argv[i];
+    } else {
+      pathCount = 0;
+      break;
+    }
+  }
+  if (pathCount != 2) {
+    fprintf(stderr, "usage: %s [-t tolerance] [-q] golden.lcap new.lcap\n", argv[0]);
+    return 2;
+  }
+
+  CaptureReader captures[2];
+  for (int c = 0; c < 2; ++c) {
+    if (!captures[c].open(paths[c])) {
+      fprintf(stderr, "%s: %s\n", paths[c], captures[c].error());
+      return 2;
+    }
+  }
+  const CaptureHeader& golden = captures[0].header;
+  const CaptureHeader& other = captures[1].header;
+  if (golden.ledCount != other.ledCount || golden.mode != other.mode) {
+    fprintf(stderr, "captures don't match up: %s at %u leds against %s at %u leds\n", golden.modeName, golden.ledCount,
+            other.modeName, other.ledCount);
+    return 2;
+  }
+  if (golden.seed != other.seed && !quiet) {
+    printf("warning: seeds differ (%u and %u)\n", golden.seed, other.seed);
+  }
+
+  // Step through the union of both captures' frame times, comparing what
+  // each had sent by then
+  static const char *kChannels[] = {"red", "green", "blue"};
+  unsigned long compared = 0, differing = 0;
+  FrameError worst = {0, 0, 0};
+  uint64_t worstMicros = 0;
+  unsigned long worstFrame = 0;
+  while (captures[0].hasNext() || captures[1].hasNext()) {
+    uint64_t t = UINT64_MAX;
+    for (int c = 0; c < 2; ++c) {
+      if (captures[c].hasNext() && captures[c].nextMicros() < t) {
+        t = captures[c].nextMicros();
+      }
+    }
+    for (int c = 0; c < 2; ++c) {
+      if (captures[c].hasNext() && captures[c].nextMicros() == t) {
+        captures[c].next();
+      }
+    }
+
+    FrameError error = compareFrames(captures[0].rgb(), captures[1].rgb(), golden.ledCount);
+    ++compared;
+    if (error.maxError > 0) {
+      ++differing;
+    }
+    if (error.maxError > worst.maxError) {
+      worst = error;
+      worstMicros = t;
+      worstFrame = captures[0].framesRead();
+    }
+  }
+  for (int c = 0; c < 2; ++c) {
+    if (captures[c].error()) {
+      fprintf(stderr, "%s: frame %lu: %s\n", paths[c], captures[c].framesRead() + 1, captures[c].error());
+      return 2;
+    }
+  }
+
+  if (!quiet) {
+    printf("%s, %u leds: %lu frames compared, %lu differ\n", golden.modeName, golden.ledCount, compared, differing);
+    if (worst.maxError > 0) {
+      printf("max error %u: pixel %u %s, first at %.3fs (golden frame %lu)\n", worst.maxError, worst.pixel,
+             kChannels[worst.channel], worstMicros / 1000000.0, worstFrame);
+    } else {
+      printf("max error 0\n");
+    }
+  }
+  return (worst.maxError > tolerance ? 1 : 0);
+}
@@ -0,0 +1,211 @@
+// Micro-benchmarks for individual color kernels.
+//
+// Each kernel is timed over a buffer of pseudo-random pixels and reported in
+// ns/pixel and TSC cycles/pixel (x86 only), next to the code it replaced where
+// that code is kept here for reference.
+
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "Config.h"
+#include "Utilities.h"
+#include "Color.h"
+#include "kernels.h"
+
+static const unsigned int kPixels = 4096;
+static const unsigned int kRepeats = 2000;
+
+static volatile uint8_t sSink;
+
+struct KernelTiming {
+  double nsPerPixel;
+  double cyclesPerPixel;
+};
+
+template <class F>
+static KernelTiming timeKernel(F kernel)
+{
+  using namespace std::chrono;
+  kernel(); // warm up
+  steady_clock::time_point start = steady_clock::now();
+#if HAVE_TSC
+  uint64_t startCycles = __rdtsc();
+#endif
+  for (unsigned int r = 0; r < kRepeats; ++r) {
+    kernel();
+  }
+  KernelTiming timing;
+#if HAVE_TSC
+  timing.cyclesPerPixel = (__rdtsc() - startCycles) / (double)(kPixels * kRepeats);
+#else
+  timing.cyclesPerPixel = 0;
+#endif
+  timing.nsPerPixel = duration_cast<nanoseconds>(steady_clock::now() - start).count() / (double)(kPixels * kRepeats);
+  return timing;
+}
+
+static void printTiming(const char *name, KernelTiming timing)
+{
+  printf("  %-48s %8.2f ns/px %8.2f cycles/px\n", name, timing.nsPerPixel, timing.cyclesPerPixel);
+}
+
+/* ColorWithInterpolatedColors */
+
+// The divide-per-channel version this replaced
+static Color ReferenceColorWithInterpolatedColors(Color c1, Color c2, uint8_t transition, uint8_t intensity)
+{
+  byte r, g, b;
+  r = c1.red - transition * c1.red / 0xFF + transition * c2.red / 0xFF;
+  r = intensity * r / 0xFF;
+  g = c1.green - transition * c1.green / 0xFF + transition * c2.green / 0xFF;
+  g = intensity * g / 0xFF;
+  b = c1.blue - transition * c1.blue / 0xFF + transition * c2.blue / 0xFF;
+  b = (int)intensity * b / 0xFF;
+  return MakeColor(r, g, b);
+}
+
+static void benchmarkInterpolation()
+{
+  printf("ColorWithInterpolatedColors\n");
+
+  // Every (c1, c2, transition) at full intensity, plus random intensities
+  unsigned long mismatches = 0;
+  for (unsigned int c1 = 0; c1 < 0x100; ++c1) {
+    for (unsigned int c2 = 0; c2 < 0x100; ++c2) {
+      for (unsigned int t = 0; t < 0x100; ++t) {
+        uint8_t intensity = (t & 1 ? 0xFF : fast_rand(0x100));
+        Color a(c1, c2, t), b(c2, t, c1);
+        Color expected = ReferenceColorWithInterpolatedColors(a, b, t, intensity);
+        Color actual = ColorWithInterpolatedColors(a, b, t, intensity);
+        if (!ColorIsEqualToColor(expected, actual)) {
+          ++mismatches;
+        }
+      }
+    }
+  }
+  printf("  mismatches against reference: %lu of %u\n", mismatches, 0x1000000);
+
+  static Color from[kPixels], to[kPixels], result[kPixels];
+  gRandom.fill((uint8_t *)from, sizeof(from));
+  gRandom.fill((uint8_t *)to, sizeof(to));
+  uint8_t transition = 0;
+  printTiming("reference (divide)", timeKernel([&]() {
+    ++transition;
+    for (unsigned int i = 0; i < kPixels; ++i) {
+      result[i] = ReferenceColorWithInterpolatedColors(from[i], to[i], transition, 0xB0);
+    }
+    sSink = result[transition].red;
+  }));
+  printTiming("ColorWithInterpolatedColors", timeKernel([&]() {
+    ++transition;
+    for (unsigned int i = 0; i < kPixels; ++i) {
+      result[i] = ColorWithInterpolatedColors(from[i], to[i], transition, 0xB0);
+    }
+    sSink = result[transition].red;
+  }));
+  printTiming("ColorsWithInterpolatedColors (span)", timeKernel([&]() {
+    ++transition;
+    ColorsWithInterpolatedColors(result, from, to, kPixels, transition, 0xB0);
+    sSink = result[transition].red;
+  }));
+  printTiming("ColorsWithInterpolatedColor (span, one target)", timeKernel([&]() {
+    ++transition;
+    ColorsWithInterpolatedColor(result, from, kBlackColor, kPixels, transition, 0xFF);
+    sSink = result[transition].red;
+  }));
+}
+
+/* Palette */
+
+static const Color kReferenceRainbow[] = {kRedColor, kOrangeColor, kYellowColor, kGreenColor, kBlueColor, kIndigoColor, kVioletColor};
+
+// The float lookup the tables replaced, minus its read past the last color
+static Color ReferencePaletteColor(const Color *colors, unsigned int count, float location)
+{
+  location = fmodf(fmodf(location, count) + count, count);
+  
+  if ((int)location == location) {
+    return colors[(int)location];
+  } else {
+    float index;
+    float fraction = modff(location, &index);
+    Color c1 = colors[(int)index];
+    Color c2 = colors[((int)index + 1) % count];
+    return ColorWithInterpolatedColors(c1, c2, 0xFF * fraction, 0xFF);
+  }
+}
+
+static void benchmarkPalette()
+{
+  printf("Palette::getColor\n");
+
+  const unsigned int count = sizeof(kReferenceRainbow) / sizeof(kReferenceRainbow[0]);
+  unsigned int mismatches = 0;
+  for (unsigned int n = 0; n < 2 * count; ++n) {
+    Color expected = ReferencePaletteColor(kReferenceRainbow, count, n);
+    if (!ColorIsEqualToColor(expected, ROYGBIVRainbow.getColor(ROYGBIVRainbow.indexForColor(n)))) {
+      ++mismatches;
+    }
+  }
+  printf("  color mismatches against reference: %u of %u\n", mismatches, 2 * count);
+
+  static Color result[kPixels];
+  static float locations[kPixels];
+  static uint8_t indexes[kPixels];
+  for (unsigned int i = 0; i < kPixels; ++i) {
+    indexes[i] = fast_rand(0x100);
+    locations[i] = indexes[i] * count / 256.0;
+  }
+  printTiming("reference (float)", timeKernel([&]() {
+    for (unsigned int i = 0; i < kPixels; ++i) {
+      result[i] = ReferencePaletteColor(kReferenceRainbow, count, locations[i]);
+    }
+    sSink = result[indexes[0]].red;
+  }));
+  printTiming("getColor (table)", timeKernel([&]() {
+    for (unsigned int i = 0; i < kPixels; ++i) {
+      result[i] = ROYGBIVRainbow.getColor(indexes[i]);
+    }
+    sSink = result[indexes[0]].red;
+  }));
+}
+
+/* Random numbers */
+
+static void benchmarkRandom()
+{
+  printf("Random numbers\n");
+
+  static uint8_t bytes[kPixels];
+  static uint16_t values[kPixels];
+  printTiming("fast_rand(0x100) per byte", timeKernel([&]() {
+    for (unsigned int i = 0; i < kPixels; ++i) {
+      bytes[i] = fast_rand(0x100);
+    }
+    sSink = bytes[bytes[0]];
+  }));
+  printTiming("RandomStream::fill bytes", timeKernel([&]() {
+    gRandom.fill(bytes, kPixels);
+    sSink = bytes[bytes[0]];
+  }));
+  printTiming("fast_rand(1000) per value", timeKernel([&]() {
+    for (unsigned int i = 0; i < kPixels; ++i) {
+      values[i] = fast_rand(1000);
+    }
+    sSink = values[bytes[0]];
+  }));
+  printTiming("RandomStream::fill values below 1000", timeKernel([&]() {
+    gRandom.fill(values, kPixels, 1000);
+    sSink = values[bytes[0]];
+  }));
+}
+
+void runKernelBenchmarks()
+{
+  benchmarkInterpolation();
+  benchmarkPalette();
+  benchmarkRandom();
+}
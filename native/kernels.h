@@ -0,0 +1,7 @@
+#ifndef NATIVE_KERNELS_H
+#define NATIVE_KERNELS_H
+
+// Micro-benchmarks for individual color kernels, run with `lights_bench -k`.
+void runKernelBenchmarks();
+
+#endif // NATIVE_KERNELS_H
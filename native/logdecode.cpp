@@ -0,0 +1,96 @@
+// Expands a binary log (a board built with LOG_BINARY) back into text.
+//
+// Reads the raw serial stream, e.g. captured with
+//   pio device monitor --raw > capture.bin
+// and prints each message on its own line. Anything between records, like
+// output from before the logger was set up, passes through untouched.
+//
+// usage: lights_logdecode [capture.bin]    (stdin without a file)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Log.h"
+
+static const unsigned int kMaxFormats = 256;
+static const unsigned int kMaxFormatLength = 256;
+
+int main(int argc, char **argv)
+{
+  FILE *in = stdin;
+  if (argc > 2 || (argc == 2 && argv[1][0] == '-')) {
+    fprintf(stderr, "usage: %s [capture.bin]\n", argv[0]);
+    return 1;
+  }
+  if (argc == 2) {
+    in = fopen(argv[1], "rb");
+    if (!in) {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+
+  static char formats[kMaxFormats][kMaxFormatLength];
+  static bool defined[kMaxFormats];
+  unsigned long messages = 0, dropped = 0, undefined = 0;
+
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    if (c != kLogRecordMark) {
+      putchar(c);
+      continue;
+    }
+    int type = fgetc(in);
+    if (type == LogRecordFormat) {
+      int id = fgetc(in);
+      if (id == EOF) {
+        break;
+      }
+      unsigned int length = 0;
+      while ((c = fgetc(in)) != EOF && c != '\0') {
+        if (length < kMaxFormatLength - 1) {
+          formats[id][length++] = c;
+        }
+      }
+      formats[id][length] = '\0';
+      defined[id] = true;
+    } else if (type == LogRecordMessage) {
+      int id = fgetc(in);
+      int argBytes = fgetc(in);
+      if (id == EOF || argBytes == EOF) {
+        break;
+      }
+      uint8_t args[256];
+      if (fread(args, 1, argBytes, in) != (size_t)argBytes) {
+        break;
+      }
+      ++messages;
+      if (!defined[id]) {
+        // The definition went out before the capture started
+        printf("[format %d not seen, %d argument bytes]\n", id, argBytes);
+        ++undefined;
+        continue;
+      }
+      char line[512];
+      logFormatPacked(line, sizeof(line), formats[id], args, argBytes);
+      printf("%s\n", line);
+    } else if (type == LogRecordDropped) {
+      int lo = fgetc(in);
+      int hi = fgetc(in);
+      if (lo == EOF || hi == EOF) {
+        break;
+      }
+      printf("(%d log messages dropped)\n", lo | (hi << 8));
+      dropped += lo | (hi << 8);
+    } else if (type != EOF) {
+      putchar(kLogRecordMark);
+      putchar(type);
+    }
+  }
+
+  fprintf(stderr, "%lu messages, %lu dropped on the board, %lu with unknown formats\n", messages, dropped, undefined);
+  if (in != stdin) {
+    fclose(in);
+  }
+  return 0;
+}
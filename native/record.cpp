@@ -0,0 +1,110 @@
+// Records what each mode sends to the strand into a capture (Capture.h), for
+// comparing against a golden capture with lights_capdiff.
+//
+// Every mode gets a fresh Scene, the same seed and a virtual clock started at
+// the same time, so a mode's capture doesn't depend on which modes ran before
+// it and the same build always records the same frames.
+//
+// usage: lights_record_<count> [-f frames] [-m mode] [-s seed] [-v] [directory]
+//   Writes <directory>/<mode>.lcap for each mode (the current directory by
+//   default). 1200 frames, 10s at 120fps, and seed 1 by default.
+
+#include "Config.h"
+#include "Utilities.h"
+#include "Color.h"
+#include "Light.h"
+#include "Scene.h"
+#include "ModeNames.h"
+#include "Capture.h"
+
+static const unsigned long kFrameMicros = 1000000 / 120;
+static const uint64_t kStartMicros = 1000000;
+
+// Writes every presented frame into a capture, timed by the virtual clock
+class CaptureOutput : public OutputDriver {
+public:
+  CaptureOutput(unsigned int count) : OutputDriver(count, false) {
+    addStrand(0, count);
+  }
+
+  CaptureWriter writer;
+
+protected:
+  void send() {
+    static_assert(sizeof(CRGB) == 3, "CRGB isn't packed red, green, blue");
+    writer.addFrame(micros(), (const uint8_t *)_front);
+  }
+};
+
+int main(int argc, char **argv)
+{
+  unsigned int frames = 1200;
+  const char *onlyMode = NULL;
+  uint32_t seed = 1;
+  bool verbose = false;
+  const char *directory = ".";
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+      frames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+      onlyMode = argv[++i];
+    } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "-v") == 0) {
+      verbose = true;
+    } else if (argv[i][0] != '-' && i == argc - 1) {
+      directory = argv[i];
+    } else {
+      fprintf(stderr, "usage: %s [-f frames] [-m mode] [-s seed] [-v] [directory]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  Serial.sink = (verbose ? stderr : NULL);
+  nativeSetVirtualClock(true);
+
+  unsigned int recorded = 0;
+  for (unsigned int m = 0; m < ARRAY_SIZE(kModeNames); ++m) {
+    const ModeName& mode = kModeNames[m];
+    if (onlyMode && strcmp(onlyMode, mode.name) != 0) {
+      continue;
+    }
+
+    nativeSetClock(kStartMicros);
+    randomSeedAll(seed);
+    CaptureOutput *output = new CaptureOutput(LED_COUNT);
+    Scene *scene = new Scene(LED_COUNT, output);
+    if (!scene->hasPattern(mode.mode)) {
+      delete scene;
+      continue;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s.lcap", directory, mode.name);
+    CaptureHeader header = {LED_COUNT, seed, (uint8_t)mode.mode, ""};
+    strncpy(header.modeName, mode.name, sizeof(header.modeName) - 1);
+    if (!output->writer.open(path, header)) {
+      perror(path);
+      delete scene;
+      return 1;
+    }
+
+    scene->setMode(mode.mode);
+    for (unsigned int f = 0; f < frames; ++f) {
+      nativeAdvanceClock(kFrameMicros);
+      scene->tick();
+      logDrain(kFrameMicros);
+      scene->idle(kFrameMicros);
+    }
+    printf("%-18s %6u leds %7lu frames  %s\n", mode.name, (unsigned)LED_COUNT, output->writer.frameCount(), path);
+    delete scene; // closes the capture
+    ++recorded;
+  }
+  logFlush();
+
+  if (recorded == 0) {
+    fprintf(stderr, "no modes recorded\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,87 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+// A block of memory allocated once at boot and handed out by bumping an offset.
+// Everything in it is released at once by reset(), so per-mode state can come
+// and go every mode change without ever touching the heap, and the heap can't
+// fragment over days of mode rotation.
+class Arena {
+public:
+  Arena(size_t capacity);
+  ~Arena();
+
+  // NULL if the arena is full. Nothing is zeroed.
+  void *alloc(size_t size);
+  template <class T>
+  T *alloc(unsigned int count) {
+    return (T *)alloc(count * sizeof(T));
+  }
+
+  // Release everything allocated since the last reset
+  void reset() {
+    _used = 0;
+    _highWater = 0;
+  }
+
+  size_t capacity() {
+    return _capacity;
+  }
+  size_t used() {
+    return _used;
+  }
+  // Most ever used at once since the last reset
+  size_t highWater() {
+    return _highWater;
+  }
+
+  // Wide enough for anything the modes store. Each alloc() may waste up to
+  // kAlignment - 1 bytes rounding up to it.
+  static const size_t kAlignment = (sizeof(unsigned long) > sizeof(void *) ? sizeof(unsigned long) : sizeof(void *));
+
+  // What alloc(size) takes out of the arena, rounding included, so the sizes
+  // of every alloc() a user makes add up to what it needs
+  static size_t bytes(size_t size) {
+    return (size + kAlignment - 1) & ~(kAlignment - 1);
+  }
+  template <class T>
+  static size_t bytes(unsigned int count) {
+    return bytes(count * sizeof(T));
+  }
+
+private:
+  uint8_t *_storage;
+  size_t _capacity;
+  size_t _used = 0;
+  size_t _highWater = 0;
+};
+
+Arena::Arena(size_t capacity) : _capacity(capacity)
+{
+  _storage = (uint8_t *)malloc(capacity);
+  assert(_storage != NULL, "Arena: out of memory at boot");
+  if (!_storage) {
+    _capacity = 0;
+  }
+}
+
+Arena::~Arena()
+{
+  free(_storage);
+}
+
+void *Arena::alloc(size_t size)
+{
+  size_t start = (_used + kAlignment - 1) & ~(kAlignment - 1);
+  if (start + size > _capacity) {
+    logf("Arena: %u bytes requested, %u of %u used", (unsigned)size, (unsigned)_used, (unsigned)_capacity);
+    assert(false, "Arena exhausted");
+    return NULL;
+  }
+  _used = start + size;
+  if (_used > _highWater) {
+    _highWater = _used;
+  }
+  return _storage + start;
+}
+
+#endif // ARENA_H
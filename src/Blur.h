@@ -0,0 +1,142 @@
+#ifndef BLUR_H
+#define BLUR_H
+
+#include "Color.h"
+#include "Arena.h"
+
+// Box blur with decay around a ring of lights, in integer math. Each light
+// becomes the average of the lights within width of it that are at least
+// threshold bright (red + green + blue), scaled down by decay like scale8().
+//
+// The window slides: each step adds the light entering it and takes out the
+// one leaving, so a light costs the same whatever the width. The window's
+// lights are kept as they were read, which lets one pass be spread over
+// several frames while the strand changes underneath it. next() steps one
+// light and wraps around to start the next pass.
+//
+// Its buffers come from the mode arena, for patterns wanting glow or trails.
+class Blur {
+public:
+  // Widest window whose size fits a byte and whose sums, 255 per light, fit
+  // 16 bits. Wider is clamped to it.
+  static const uint8_t kMaxWidth = 127;
+
+  // Blurs lightCount lights, taking the window from arena
+  void begin(Arena& arena, unsigned int lightCount, uint8_t width, uint8_t decay, uint8_t threshold);
+
+  // Blurred color of the next light in the pass, read from colors, and sets
+  // index to which light it's for
+  Color next(const Color *colors, unsigned int& index);
+
+  static size_t arenaBytes(uint8_t width) {
+    width = min(width, kMaxWidth);
+    return Arena::bytes<Color>(2 * width + 1) + Arena::bytes<uint32_t>(2 * width + 2);
+  }
+
+private:
+  unsigned int _lightCount;
+  uint8_t _windowSize; // 2 * width + 1
+  uint8_t _decay;
+  uint8_t _threshold;
+
+  Color *_window; // ring of the lights in the window, as they were read
+  uint8_t _oldest; // in _window
+  uint32_t *_reciprocal; // 0x10000 / count, rounded up, for dividing the sums
+  unsigned int _target; // light the window is centered on
+  bool _filled;
+
+  uint16_t _red, _green, _blue;
+  uint8_t _count; // lights in the window bright enough to count
+
+  bool counts(Color c) {
+    return c.red + c.green + c.blue >= _threshold;
+  }
+  void add(Color c);
+  void remove(Color c);
+  void fill(const Color *colors);
+};
+
+void Blur::begin(Arena& arena, unsigned int lightCount, uint8_t width, uint8_t decay, uint8_t threshold)
+{
+  _lightCount = lightCount;
+  _windowSize = 2 * min(width, kMaxWidth) + 1;
+  _decay = decay;
+  _threshold = threshold;
+  _window = arena.alloc<Color>(_windowSize);
+  _reciprocal = arena.alloc<uint32_t>(_windowSize + 1);
+  _reciprocal[0] = 0;
+  for (unsigned int count = 1; count <= _windowSize; ++count) {
+    _reciprocal[count] = (0x10000UL + count - 1) / count;
+  }
+  _target = 0;
+  _filled = false;
+}
+
+void Blur::add(Color c)
+{
+  if (counts(c)) {
+    _red += c.red;
+    _green += c.green;
+    _blue += c.blue;
+    ++_count;
+  }
+}
+
+void Blur::remove(Color c)
+{
+  if (counts(c)) {
+    _red -= c.red;
+    _green -= c.green;
+    _blue -= c.blue;
+    --_count;
+  }
+}
+
+void Blur::fill(const Color *colors)
+{
+  _red = _green = _blue = 0;
+  _count = 0;
+  const unsigned int width = _windowSize / 2;
+  for (uint8_t w = 0; w < _windowSize; ++w) {
+    Color c = colors[(_target + _lightCount * (width / _lightCount + 1) - width + w) % _lightCount];
+    _window[w] = c;
+    add(c);
+  }
+  _oldest = 0;
+  _filled = true;
+}
+
+Color Blur::next(const Color *colors, unsigned int& index)
+{
+  if (!_filled) {
+    fill(colors);
+  }
+  index = _target;
+
+  Color c = kBlackColor;
+  if (_count > 0) {
+    // 16.16 reciprocal, so each channel's average takes a multiply
+    const uint32_t reciprocal = _reciprocal[_count];
+    c.red = scale8(((uint32_t)_red * reciprocal) >> 16, _decay);
+    c.green = scale8(((uint32_t)_green * reciprocal) >> 16, _decay);
+    c.blue = scale8(((uint32_t)_blue * reciprocal) >> 16, _decay);
+  }
+
+  // Slide along one light
+  if (++_target == _lightCount) {
+    // Start the next pass fresh, since the wrap would bring in stale lights
+    _target = 0;
+    _filled = false;
+  } else {
+    const unsigned int entering = (_target + _windowSize / 2) % _lightCount;
+    remove(_window[_oldest]);
+    _window[_oldest] = colors[entering];
+    add(_window[_oldest]);
+    if (++_oldest == _windowSize) {
+      _oldest = 0;
+    }
+  }
+  return c;
+}
+
+#endif // BLUR_H
@@ -3,6 +3,7 @@
 #include <FastLED.h>
 
 #include "Arduino.h"
+#include "Config.h"
 #include "Color.h"
 #include "Utilities.h"
 
@@ -24,17 +25,42 @@ bool ColorIsEqualToColor(Color c1, Color c2)
   return (c1.red == c2.red && c1.green == c2.green && c1.blue == c2.blue);
 }
 
+// x / 0xFF, rounded down, for any product of two bytes
+static inline uint8_t div255(uint16_t x)
+{
+  return (x + 1 + (x >> 8)) >> 8;
+}
+
+// Same rounding as c1 - t * c1 / 0xFF + t * c2 / 0xFF, scaled by intensity / 0xFF, without dividing
+static inline uint8_t interpolate8(uint8_t c1, uint8_t c2, uint8_t transition, uint8_t intensity)
+{
+  uint8_t c = c1 - div255(transition * c1) + div255(transition * c2);
+  return (intensity == 0xFF ? c : div255(intensity * c));
+}
+
 Color ColorWithInterpolatedColors(Color c1, Color c2, uint8_t transition, uint8_t intensity)
 {
-  byte r, g, b;
-  r = c1.red - transition * c1.red / 0xFF + transition * c2.red / 0xFF;
-  r = intensity * r / 0xFF;
-  g = c1.green - transition * c1.green / 0xFF + transition * c2.green / 0xFF;
-  g = intensity * g / 0xFF;
-  b = c1.blue - transition * c1.blue / 0xFF + transition * c2.blue / 0xFF;
-  b = (int)intensity * b / 0xFF;
-  
-  return MakeColor(r, g, b);
+  return MakeColor(interpolate8(c1.red, c2.red, transition, intensity),
+                   interpolate8(c1.green, c2.green, transition, intensity),
+                   interpolate8(c1.blue, c2.blue, transition, intensity));
+}
+
+void ColorsWithInterpolatedColors(Color *result, const Color *c1, const Color *c2, unsigned int count, uint8_t transition, uint8_t intensity)
+{
+  for (unsigned int i = 0; i < count; ++i) {
+    result[i].red = interpolate8(c1[i].red, c2[i].red, transition, intensity);
+    result[i].green = interpolate8(c1[i].green, c2[i].green, transition, intensity);
+    result[i].blue = interpolate8(c1[i].blue, c2[i].blue, transition, intensity);
+  }
+}
+
+void ColorsWithInterpolatedColor(Color *result, const Color *c1, Color c2, unsigned int count, uint8_t transition, uint8_t intensity)
+{
+  for (unsigned int i = 0; i < count; ++i) {
+    result[i].red = interpolate8(c1[i].red, c2.red, transition, intensity);
+    result[i].green = interpolate8(c1[i].green, c2.green, transition, intensity);
+    result[i].blue = interpolate8(c1[i].blue, c2.blue, transition, intensity);
+  }
 }
 
 bool ColorTransitionWillProduceWhite(Color c1, Color c2)
@@ -63,32 +89,46 @@ Palette::Palette(unsigned int count, ...)
   }
   
   va_end(args);
+
+  // At boot, so sampling never touches the heap mid-frame
+  buildTable();
 }
 
 Palette::~Palette()
 {
-  delete colors;
+  free(colors);
+  free(table);
 }
 
-Color Palette::randomColor()
+Color Palette::randomColor(RandomStream& random)
 {
-  return colors[fast_rand(count)];
+  return colors[random.below(count)];
 }
 
-Color Palette::getColor(float location)
+void Palette::buildTable()
 {
-  // FIXME: replace with FastLED palettes
-  // ensure location is positive and in range
-  location = fmodf(fmodf(location, count) + count, count);
+  const unsigned int size = 1 << PALETTE_TABLE_BITS;
+  table = (Color *)malloc(size * sizeof(Color));
   
-  if ((int)location == location) {
-    return colors[(int)location];
-  } else {
-    float index;
-    float fraction = modff(location, &index);
-    Color c1 = colors[(int)index];
-    Color c2 = colors[(int)index + 1];
-    return ColorWithInterpolatedColors(c1, c2, 0xFF * fraction, 0xFF);
+  // Color n sits at n * size / count, so lookups at indexForColor(n) are exact.
+  // The last segment blends back into the first color.
+  for (unsigned int n = 0; n < count; ++n) {
+    unsigned int start = n * size / count;
+    unsigned int end = (n + 1) * size / count;
+    Color c1 = colors[n];
+    Color c2 = colors[n + 1 < count ? n + 1 : 0];
+    for (unsigned int i = start; i < end; ++i) {
+      table[i] = ColorWithInterpolatedColors(c1, c2, 0xFF * (i - start) / (end - start), 0xFF);
+    }
   }
 }
 
+Color Palette::getColor(uint8_t index)
+{
+  return table[index >> (8 - PALETTE_TABLE_BITS)];
+}
+
+uint8_t Palette::indexForColor(unsigned int n)
+{
+  return (uint8_t)(((unsigned long)n << 8) / count);
+}
@@ -2,6 +2,8 @@
 #define COLOR_H
 
 #include <FastLED.h>
+
+#include "Random.h"
 #if USE_STL
 #include <string>
 #endif
@@ -56,18 +58,28 @@ static const Color kNightColor = MakeColor(0, 0, 0x10);
 bool ColorIsEqualToColor(Color c1, Color c2);
 
 Color ColorWithInterpolatedColors(Color c1, Color c2, uint8_t transition, uint8_t intensity);
+// Span forms: blend count pixels at once. result may alias c1.
+void ColorsWithInterpolatedColors(Color *result, const Color *c1, const Color *c2, unsigned int count, uint8_t transition, uint8_t intensity);
+void ColorsWithInterpolatedColor(Color *result, const Color *c1, Color c2, unsigned int count, uint8_t transition, uint8_t intensity);
 
 bool ColorTransitionWillProduceWhite(Color c1, Color c2);
 
+// A looping gradient through a list of colors, looked up by an 8-bit index
+// that wraps around the whole palette. The gradient is expanded into a table
+// (1 << PALETTE_TABLE_BITS entries) when the palette is made.
 class Palette {
 public:
   Palette(unsigned int count, ...);
   ~Palette();
-  Color randomColor();
-  Color getColor(float location);
+  Color randomColor(RandomStream& random);
+  Color getColor(uint8_t index);
+  // Index at which getColor returns exactly the nth color (wrapping)
+  uint8_t indexForColor(unsigned int n);
   unsigned int count;
 private:
   Color *colors;
+  Color *table;
+  void buildTable();
 };
 
 extern Palette RGBRainbow;
@@ -0,0 +1,139 @@
+#ifndef COLORCORRECTION_H
+#define COLORCORRECTION_H
+
+#include "Config.h"
+#include "Color.h"
+
+// Per-strand color correction: gamma, white balance and a brightness cap,
+// folded into one 256-entry table per channel so updateStrand() corrects a
+// light with three table reads. The tables are computed by the compiler and
+// live in PROGMEM; nothing is calculated on the board.
+//
+// A profile is chosen per build env (the COLOR_* flags below) and can be
+// overridden per strand segment (PixelSegment::profile in PixelMap.h), so a
+// strand from a different batch can be matched to the rest.
+//
+// Parameters are integers so they can be template arguments: gamma in
+// hundredths, each channel's white balance in thousandths, and the brightness
+// cap out of 255.
+
+struct ColorProfile {
+  const uint8_t *red;
+  const uint8_t *green;
+  const uint8_t *blue;
+
+  void apply(Color& c) const {
+    c.red = pgm_read_byte(red + c.red);
+    c.green = pgm_read_byte(green + c.green);
+    c.blue = pgm_read_byte(blue + c.blue);
+  }
+};
+
+/* Compile-time table generation */
+
+static constexpr double lutLn2 = 0.6931471805599453;
+
+static constexpr double lutAtanhSeries(double y2, double power, int k)
+{
+  return (k > 24 ? 0 : power / (2 * k + 1) + lutAtanhSeries(y2, power * y2, k + 1));
+}
+
+// Natural log, for 0 < x <= 1
+static constexpr double lutLn(double x)
+{
+  return (x < 0.5 ? lutLn(x * 2) - lutLn2 : 2 * lutAtanhSeries(((x - 1) / (x + 1)) * ((x - 1) / (x + 1)), (x - 1) / (x + 1), 0));
+}
+
+static constexpr double lutExpSeries(double x, double term, int k)
+{
+  return (k > 16 ? 0 : term + lutExpSeries(x, term * x / (k + 1), k + 1));
+}
+
+static constexpr double lutSquare(double x)
+{
+  return x * x;
+}
+
+// e^x, for x <= 0
+static constexpr double lutExp(double x)
+{
+  return (x < -0.5 ? lutSquare(lutExp(x / 2)) : lutExpSeries(x, 1, 0));
+}
+
+static constexpr uint8_t lutClamp(double level)
+{
+  return (level >= 255 ? 255 : (uint8_t)level);
+}
+
+// Output level for input i. Without gamma this is exact integer math, so a
+// plain white balance scales like it would by hand.
+static constexpr uint8_t lutLevel(unsigned int gamma100, unsigned int balance1000, unsigned int max255, unsigned int i)
+{
+  return (gamma100 == 100 ? lutClamp((unsigned long)i * balance1000 * max255 / (1000UL * 255))
+          : i == 0 ? 0
+          : lutClamp(lutExp(gamma100 / 100.0 * lutLn(i / 255.0)) * 255 * balance1000 / 1000 * max255 / 255 + 0.5));
+}
+
+static_assert(lutLevel(100, 1000, 255, 200) == 200, "identity table isn't the identity");
+static_assert(lutLevel(220, 1000, 255, 255) == 255, "gamma doesn't keep full on");
+static_assert(lutLevel(220, 1000, 255, 128) == 56, "gamma 2.2 is off");
+
+template <int... I>
+struct LUTIndexes {};
+template <int N, int... I>
+struct MakeLUTIndexes : MakeLUTIndexes<N - 1, N - 1, I...> {};
+template <int... I>
+struct MakeLUTIndexes<0, I...> {
+  typedef LUTIndexes<I...> type;
+};
+
+// One channel's table. Channels and profiles with the same parameters share it.
+template <unsigned int Gamma100, unsigned int Balance1000, unsigned int Max255, class Indexes = typename MakeLUTIndexes<256>::type>
+struct ChannelLUT;
+
+template <unsigned int Gamma100, unsigned int Balance1000, unsigned int Max255, int... I>
+struct ChannelLUT<Gamma100, Balance1000, Max255, LUTIndexes<I...> > {
+  static const uint8_t levels[256];
+};
+
+template <unsigned int Gamma100, unsigned int Balance1000, unsigned int Max255, int... I>
+const uint8_t ChannelLUT<Gamma100, Balance1000, Max255, LUTIndexes<I...> >::levels[256] PROGMEM = {lutLevel(Gamma100, Balance1000, Max255, I)...};
+
+#define COLOR_PROFILE(gamma100, red1000, green1000, blue1000, max255) \
+  {ChannelLUT<gamma100, red1000, max255>::levels, ChannelLUT<gamma100, green1000, max255>::levels, ChannelLUT<gamma100, blue1000, max255>::levels}
+
+/* Profiles */
+
+// The build env's profile. e.g. -D COLOR_GAMMA=220 -D COLOR_BLUE=850
+#if MEGA_WS2811
+// The WS2811 strands I use run a little short on red
+#define COLOR_RED 1100
+#endif
+
+#if defined(COLOR_GAMMA) || defined(COLOR_RED) || defined(COLOR_GREEN) || defined(COLOR_BLUE) || defined(COLOR_MAX)
+#define COLOR_CORRECTION 1
+#endif
+#ifndef COLOR_GAMMA
+#define COLOR_GAMMA 100
+#endif
+#ifndef COLOR_RED
+#define COLOR_RED 1000
+#endif
+#ifndef COLOR_GREEN
+#define COLOR_GREEN 1000
+#endif
+#ifndef COLOR_BLUE
+#define COLOR_BLUE 1000
+#endif
+#ifndef COLOR_MAX
+#define COLOR_MAX 255
+#endif
+
+// Profile 0 is the env's. Add more for segments that need their own, e.g.:
+//   COLOR_PROFILE(220, 1000, 900, 800, 255), // the greenish batch
+// and set COLOR_CORRECTION.
+static const ColorProfile kColorProfiles[] = {
+  COLOR_PROFILE(COLOR_GAMMA, COLOR_RED, COLOR_GREEN, COLOR_BLUE, COLOR_MAX),
+};
+
+#endif // COLORCORRECTION_H
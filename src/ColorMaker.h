@@ -2,6 +2,8 @@
 #define COLORMAKER_H
 
 #include "Color.h"
+#include "Arena.h"
+#include "Random.h"
 
 class ColorMaker {
 public:
@@ -11,16 +13,26 @@ public:
   unsigned int getColorCount() {
     return count;
   }
-  void prepColors(unsigned int count, unsigned long duration);
+  // Storage comes from `arena` and lasts until the arena is reset. Colors are
+  // drawn from `random`, the pattern's stream, which has to outlive them too.
+  void prepColors(Arena& arena, unsigned int count, unsigned long duration, unsigned long now, RandomStream& random);
   Color getColor(unsigned int index);
   uint8_t fadeProgress(int index);
-  void tick();
+  void tick(unsigned long now); // frame time in millis
   
   void reset();
 
+  static const size_t kBytesPerColor = sizeof(unsigned long) + 3 * sizeof(Color) + sizeof(bool);
+  // What prepColors() takes from the arena for count colors
+  static size_t arenaBytes(unsigned int count) {
+    return (count > 0 ? Arena::bytes(count * kBytesPerColor) : 0);
+  }
+
 private:
   unsigned long duration; // in millis
   unsigned int count;
+  unsigned long now = 0;
+  RandomStream *random = NULL;
   
   Color *colors = NULL;
   Color *colorTargets = NULL;
@@ -39,23 +51,31 @@ ColorMaker::~ColorMaker()
   this->reset();
 }
 
-void ColorMaker::prepColors(unsigned int count, unsigned long duration) // duration per color target
+void ColorMaker::prepColors(Arena& arena, unsigned int count, unsigned long duration, unsigned long now, RandomStream& random) // duration per color target
 {
   this->reset();
-  this->count = count;
   this->duration = duration;
+  this->now = now;
+  this->random = &random;
   
-  if (count > 0) {
-    colors = (Color *)malloc(count * sizeof(Color));
-    colorTargets = (Color *)malloc(count * sizeof(Color));
-    colorStarts = (unsigned long *)malloc(count * sizeof(unsigned long));
-    colorCache = (Color *)malloc(count * sizeof(Color));
-    colorCacheHits = (bool *)malloc(count * sizeof(bool));
+  uint8_t *p = (count > 0 ? (uint8_t *)arena.alloc(count * kBytesPerColor) : NULL);
+  if (p) {
+    this->count = count;
+    // Widest first so each array stays aligned
+    colorStarts = (unsigned long *)p;
+    p += count * sizeof(unsigned long);
+    colors = (Color *)p;
+    p += count * sizeof(Color);
+    colorTargets = (Color *)p;
+    p += count * sizeof(Color);
+    colorCache = (Color *)p;
+    p += count * sizeof(Color);
+    colorCacheHits = (bool *)p;
 
     for (unsigned int i = 0; i < count; ++i) {
-      colors[i] = NamedRainbow.randomColor();
-      colorTargets[i] = NamedRainbow.randomColor();
-      colorStarts[i] = millis();
+      colors[i] = NamedRainbow.randomColor(random);
+      colorTargets[i] = NamedRainbow.randomColor(random);
+      colorStarts[i] = now;
       colorCache[i] = kBlackColor;
       colorCacheHits[i] = false;
     }
@@ -63,7 +83,7 @@ void ColorMaker::prepColors(unsigned int count, unsigned long duration) // durat
 }
 
 uint8_t ColorMaker::fadeProgress(int index) {
-  uint8_t progress = min((uint8_t)0xFF, 0xFF * (millis() - colorStarts[index]) / duration);
+  uint8_t progress = min((uint8_t)0xFF, 0xFF * (now - colorStarts[index]) / duration);
   return progress;
 }
 
@@ -81,14 +101,15 @@ Color ColorMaker::getColor(unsigned int index)
   return colorCache[index];
 }
 
-void ColorMaker::tick()
+void ColorMaker::tick(unsigned long now)
 {
+  this->now = now;
   for (unsigned int i = 0; i < count; ++i) {
     uint8_t progress = fadeProgress(i);
     if (progress == 0xFF) {
-      colorStarts[i] = millis();
+      colorStarts[i] = now;
       colors[i] = colorTargets[i];
-      colorTargets[i] = NamedRainbow.randomColor();
+      colorTargets[i] = NamedRainbow.randomColor(*random);
     }
     colorCache[i] = kBlackColor;
     colorCacheHits[i] = false;
@@ -97,16 +118,13 @@ void ColorMaker::tick()
   
 void ColorMaker::reset()
 {
-  free(colors);
+  // The storage belongs to the arena
   colors = NULL;
-  free(colorTargets);
   colorTargets = NULL;
-  free(colorStarts);
   colorStarts = NULL;
-  free(colorCache);
   colorCache = NULL;
-  free(colorCacheHits);
   colorCacheHits = NULL;
+  random = NULL;
 
   count = 0;
 }
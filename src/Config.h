@@ -38,14 +38,89 @@
 // Some platforms do not support printing floats
 #define PRINTF_FLOATS (!MEGA && !SAMD)
 
+// Entries in each Palette lookup table (Color.h) is 1 << PALETTE_TABLE_BITS
+#if MEGA
+#define PALETTE_TABLE_BITS 6
+#else
+#define PALETTE_TABLE_BITS 8
+#endif
+
+// Whether the output can ever be dimmed: by the developer board's dial, or a
+// default below full. Builds that can't leave out the dither (Dither.h).
+#define DIMMING (DEVELOPER_BOARD || DEFAULT_BRIGHNESS < 0xFF)
+
+// Dim through a 512 byte table rebuilt when the brightness changes (Dither.h),
+// rather than a multiply per channel
+#define BRIGHTNESS_TABLE (DIMMING && !MEGA)
+
 /* Logging */
 #define DEBUG 0
 #define WAIT_FOR_SERIAL 0
 
+// Bytes of log messages held between drains, and distinct format strings (Log.h)
+#if MEGA
+#define LOG_BUFFER_BYTES 128
+#define LOG_MAX_FORMATS 24
+#else
+#define LOG_BUFFER_BYTES 1024
+#define LOG_MAX_FORMATS 64
+#endif
+// Send the log as binary records, for native/logdecode.cpp to expand
+#ifndef LOG_BINARY
+#define LOG_BINARY 0
+#endif
+// Time each stage of every frame (Profiler.h)
+#ifndef PROFILING
+#define PROFILING 0
+#endif
+
 /* Options */
 // #define TEST_MODE (ModeParity)
 #define MODE_TIME (80)
+// Frame rate for patterns that don't pick their own
+#define FRAMES_PER_SECOND 120
+// Nonzero seeds every random number from this instead of pin noise, so a
+// run can be repeated (Random.h)
+#ifndef RANDOM_SEED
+#define RANDOM_SEED 0
+#endif
+#ifndef DEFAULT_BRIGHNESS
 #define DEFAULT_BRIGHNESS 0xFF
+#endif
+
+/* Patterns */
+// Which patterns get built in (PatternRegistry.h). Turn off the ones a
+// deployment doesn't use from its env's build_flags in platformio.ini.
+#ifndef PATTERN_WAVES
+#define PATTERN_WAVES 1
+#endif
+#ifndef PATTERN_FIRE
+#define PATTERN_FIRE 1 // all four fires
+#endif
+#ifndef PATTERN_LIGHTNING_BUGS
+#define PATTERN_LIGHTNING_BUGS 1
+#endif
+#ifndef PATTERN_PARITY
+#define PATTERN_PARITY 1
+#endif
+#ifndef PATTERN_INTERFERING_WAVES
+#define PATTERN_INTERFERING_WAVES 1
+#endif
+#ifndef PATTERN_RAINBOW
+#define PATTERN_RAINBOW 1
+#endif
+#ifndef PATTERN_ACCUMULATOR
+#define PATTERN_ACCUMULATOR 1
+#endif
+#ifndef PATTERN_TWINKLE
+#define PATTERN_TWINKLE 1
+#endif
+#ifndef PATTERN_BOOM_RESPONDER
+#define PATTERN_BOOM_RESPONDER 1
+#endif
+#ifndef PATTERN_BOUNCE
+#define PATTERN_BOUNCE 1
+#endif
 
 #if DEVELOPER_BOARD
 static const bool kHasDeveloperBoard = true;
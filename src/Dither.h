@@ -0,0 +1,92 @@
+#ifndef DITHER_H
+#define DITHER_H
+
+#include "Config.h"
+#include "Color.h"
+
+// Temporal dithering for dimmed output. Scaling a channel down to low
+// brightness leaves a fraction of a step that plain scale8() throws away,
+// which is what makes dim fades band and then snap off. Here each light keeps
+// that fraction per channel and adds it to the next frame's, so a light sits
+// between two output steps by alternating between them, and the average over
+// a few frames is the exact dimmed value.
+//
+// A light carrying a fraction has to be resent every frame for that to work,
+// even when its color didn't change, so apply() says when one is left over.
+//
+// The scale is set once per frame. With BRIGHTNESS_TABLE it's resolved then
+// into every channel value's scaled result, so each channel costs a lookup.
+//
+// Builds that can't dim (DIMMING in Config.h) leave it out altogether, along
+// with its 3 bytes per light.
+class TemporalDither {
+public:
+  TemporalDither(unsigned int count);
+  ~TemporalDither();
+
+  // Scale by (scale + 1) / 256 like scale8(). Cheap when scale hasn't changed.
+  void setScale(uint8_t scale);
+
+  // Scale c, carrying the remainder to the light's next frame. True if any
+  // channel has a remainder left.
+  bool apply(unsigned int index, Color& c) {
+    uint8_t *error = _error + 3 * index;
+    return (scaleChannel(c.red, error[0]) | scaleChannel(c.green, error[1]) | scaleChannel(c.blue, error[2]));
+  }
+
+private:
+  uint8_t *_error; // remainder carried per light per channel, in 1/256ths
+  uint16_t _factor = 0x100;
+#if BRIGHTNESS_TABLE
+  uint16_t _scaled[256]; // value * _factor, in 1/256ths
+#endif
+
+  bool scaleChannel(uint8_t& value, uint8_t& error) {
+    if (value == 0) {
+      // Off is off, and a light that went dark has nothing left to carry
+      error = 0;
+      return false;
+    }
+#if BRIGHTNESS_TABLE
+    const uint16_t scaled = _scaled[value] + error;
+#else
+    const uint16_t scaled = value * _factor + error;
+#endif
+    value = scaled >> 8;
+    error = scaled & 0xFF;
+    return error != 0;
+  }
+};
+
+TemporalDither::TemporalDither(unsigned int count)
+{
+  _error = (uint8_t *)malloc(3 * count);
+  memset(_error, 0, 3 * count);
+#if BRIGHTNESS_TABLE
+  for (unsigned int v = 0; v < 256; ++v) {
+    _scaled[v] = v << 8;
+  }
+#endif
+}
+
+void TemporalDither::setScale(uint8_t scale)
+{
+  const uint16_t factor = scale + 1;
+  if (factor == _factor) {
+    return;
+  }
+  _factor = factor;
+#if BRIGHTNESS_TABLE
+  uint16_t scaled = 0;
+  for (unsigned int v = 0; v < 256; ++v, scaled += factor) {
+    _scaled[v] = scaled;
+  }
+#endif
+}
+
+TemporalDither::~TemporalDither()
+{
+  free(_error);
+}
+
+#endif // DITHER_H
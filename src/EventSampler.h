@@ -0,0 +1,65 @@
+#ifndef EVENTSAMPLER_H
+#define EVENTSAMPLER_H
+
+#include "Random.h"
+
+// Rare random events over many trials, e.g. "each light starts a blink with
+// a 1 in 1400 chance each frame", without a random number per trial. The gap
+// to the next hit is drawn from the geometric distribution instead, so only
+// the trials that hit are visited and the rest cost nothing. Hits come out
+// exactly as often, and as independently, as flipping a coin per trial.
+//
+// Trials are numbered on from one call to the next, so a mode walking its
+// lights once per frame carries the leftover gap into the next frame.
+class EventSampler {
+public:
+  // Each trial hits with a 1 in chance probability
+  void setChance(unsigned long chance, RandomStream& random);
+
+  // Steps to each hit among the next trialCount trials in turn, setting trial
+  // to its number from 0. False once there are no more, so call it until then.
+  bool next(unsigned int trialCount, unsigned int& trial, RandomStream& random);
+
+private:
+  unsigned long _chance = 0;
+  float _logMiss; // log of the chance a trial misses
+  unsigned long _next = 0; // trials until the next hit
+
+  // Misses before the next hit
+  unsigned long gap(RandomStream& random);
+};
+
+void EventSampler::setChance(unsigned long chance, RandomStream& random)
+{
+  if (chance == _chance) {
+    return;
+  }
+  _chance = chance;
+  _logMiss = (chance > 1 ? log(1 - 1.0 / chance) : 0);
+  // Gaps have no memory, so a pending one can be thrown away and redrawn
+  _next = gap(random);
+}
+
+bool EventSampler::next(unsigned int trialCount, unsigned int& trial, RandomStream& random)
+{
+  if (_next >= trialCount) {
+    _next -= trialCount;
+    return false;
+  }
+  trial = _next;
+  _next += 1 + gap(random);
+  return true;
+}
+
+unsigned long EventSampler::gap(RandomStream& random)
+{
+  if (_chance <= 1) {
+    return 0;
+  }
+  // Inverse of the geometric distribution's CDF, for uniform u in (0, 1]
+  const float u = ((random.next() >> 2) + 1) / (float)0x40000000;
+  const float misses = log(u) / _logMiss;
+  return (misses < 0xFFFFFFF ? (unsigned long)misses : 0xFFFFFFF);
+}
+
+#endif // EVENTSAMPLER_H
@@ -0,0 +1,77 @@
+#ifndef FRAMECLOCK_H
+#define FRAMECLOCK_H
+
+// The time for one frame. Sampled once at the top of Scene::tick() and handed
+// to everything that animates, so a frame sees a single "now" and pays for a
+// single timer read.
+//
+// Animation time runs at `speed` times wall time (the developer board's speed
+// dial); wall time is kept alongside for bookkeeping like mode rotation. On the
+// host build micros() comes from the stand-in's virtual clock, so a simulation
+// can step frames faster than real time.
+class FrameClock {
+public:
+  float speed = 1.0;
+
+  FrameClock();
+
+  // Sample the timer and advance both timebases
+  void tick();
+  void tick(unsigned long nowMicros);
+
+  // Animation time, scaled by speed
+  unsigned long now() const {
+    return _now;
+  }
+  unsigned long delta() const {
+    return _delta;
+  }
+  unsigned long deltaMicros() const {
+    return _deltaMicros;
+  }
+
+  // Wall time
+  unsigned long realNow() const {
+    return _realNow;
+  }
+  unsigned long realDelta() const {
+    return _realDelta;
+  }
+
+private:
+  unsigned long _lastSample;
+  unsigned long _now, _nowMicroRemainder;
+  unsigned long _realNow, _realMicroRemainder;
+  unsigned long _delta, _deltaMicros;
+  unsigned long _realDelta;
+};
+
+FrameClock::FrameClock() : _nowMicroRemainder(0), _realMicroRemainder(0), _delta(0), _deltaMicros(0), _realDelta(0)
+{
+  _lastSample = micros();
+  _now = _realNow = millis();
+}
+
+void FrameClock::tick()
+{
+  tick(micros());
+}
+
+void FrameClock::tick(unsigned long nowMicros)
+{
+  unsigned long realMicros = nowMicros - _lastSample;
+  _lastSample = nowMicros;
+
+  _realMicroRemainder += realMicros;
+  _realDelta = _realMicroRemainder / 1000;
+  _realMicroRemainder -= _realDelta * 1000;
+  _realNow += _realDelta;
+
+  _deltaMicros = (speed == 1.0 ? realMicros : (unsigned long)(realMicros * speed));
+  _nowMicroRemainder += _deltaMicros;
+  _delta = _nowMicroRemainder / 1000;
+  _nowMicroRemainder -= _delta * 1000;
+  _now += _delta;
+}
+
+#endif // FRAMECLOCK_H
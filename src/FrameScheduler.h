@@ -0,0 +1,139 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+// Starts frames on a fixed microsecond period. Each deadline is the previous
+// one plus the period, not "now" plus the period, so time spent computing a
+// frame doesn't add up into drift. A frame that runs past its deadline counts
+// as missed, and the schedule restarts from then rather than rushing extra
+// frames out to catch up. Periods that aren't a whole number of micros (8333⅓
+// at 120fps) carry the fraction from frame to frame, so a second is always
+// exactly framesPerSecond frames.
+//
+// The wait until the next deadline runs the idle hooks: work that can happen
+// between frames, like writing out the log or stepping palette blends. Every
+// hook runs at least once per frame, with a zero budget when there's no time
+// left, so none of them starve.
+class FrameScheduler {
+public:
+  // Given the micros left before the next frame. True if there's more to do.
+  typedef bool (*IdleHook)(unsigned long budgetMicros);
+
+  FrameScheduler(unsigned int framesPerSecond);
+
+  void setFramesPerSecond(unsigned int framesPerSecond);
+  bool addIdleHook(IdleHook hook);
+
+  // Run the idle hooks and return at the start of the next frame
+  void waitForNextFrame();
+
+  unsigned long missedDeadlines() {
+    return _missed;
+  }
+
+private:
+  static const uint8_t kMaxIdleHooks = 4;
+  // Hooks aren't started this close to the deadline
+  static const unsigned long kIdleMarginMicros = 200;
+
+  unsigned int _framesPerSecond = 0;
+  unsigned long _periodMicros; // rounded down
+  unsigned int _periodRemainder; // the micros a second that rounding drops
+  unsigned int _remainderCarried = 0; // toward the next extra micro, out of _framesPerSecond
+  unsigned long _deadline;
+  bool _started = false; // the timers may not run yet when this is constructed
+  unsigned long _missed = 0;
+  unsigned long _missedLogged = 0;
+  unsigned long _lastMissLog = 0;
+  IdleHook _idleHooks[kMaxIdleHooks];
+  uint8_t _idleHookCount = 0;
+
+  bool runIdleHooks(unsigned long budgetMicros);
+  // This frame's period: the rounded down one, plus a micro whenever the
+  // carried remainder adds up to one
+  unsigned long nextPeriod();
+};
+
+FrameScheduler::FrameScheduler(unsigned int framesPerSecond)
+{
+  setFramesPerSecond(framesPerSecond);
+}
+
+void FrameScheduler::setFramesPerSecond(unsigned int framesPerSecond)
+{
+  framesPerSecond = max(framesPerSecond, 1u);
+  if (framesPerSecond == _framesPerSecond) {
+    return; // called every frame, and the carried remainder has to last
+  }
+  _framesPerSecond = framesPerSecond;
+  _periodMicros = 1000000UL / _framesPerSecond;
+  _periodRemainder = 1000000UL % _framesPerSecond;
+  _remainderCarried = 0;
+}
+
+unsigned long FrameScheduler::nextPeriod()
+{
+  _remainderCarried += _periodRemainder;
+  if (_remainderCarried >= _framesPerSecond) {
+    _remainderCarried -= _framesPerSecond;
+    return _periodMicros + 1;
+  }
+  return _periodMicros;
+}
+
+bool FrameScheduler::addIdleHook(IdleHook hook)
+{
+  if (_idleHookCount == kMaxIdleHooks) {
+    return false;
+  }
+  _idleHooks[_idleHookCount++] = hook;
+  return true;
+}
+
+bool FrameScheduler::runIdleHooks(unsigned long budgetMicros)
+{
+  bool moreToDo = false;
+  for (uint8_t i = 0; i < _idleHookCount; ++i) {
+    moreToDo |= _idleHooks[i](budgetMicros);
+  }
+  return moreToDo;
+}
+
+void FrameScheduler::waitForNextFrame()
+{
+  if (!_started) {
+    _deadline = micros() + nextPeriod();
+    _started = true;
+  }
+  long remaining = (long)(_deadline - micros());
+  if (remaining <= 0) {
+    ++_missed;
+    runIdleHooks(0);
+    // Start over from now
+    _deadline = micros() + nextPeriod();
+  } else {
+    bool moreToDo = true;
+    do {
+      moreToDo = runIdleHooks(remaining > (long)kIdleMarginMicros ? remaining - kIdleMarginMicros : 0);
+      remaining = (long)(_deadline - micros());
+    } while (moreToDo && remaining > (long)kIdleMarginMicros);
+
+    if (remaining > 0) {
+      if (remaining > 1000) {
+        delay(remaining / 1000);
+      }
+      remaining = (long)(_deadline - micros());
+      if (remaining > 0) {
+        delayMicroseconds(remaining);
+      }
+    }
+    _deadline += nextPeriod();
+  }
+
+  if (_missed != _missedLogged && millis() - _lastMissLog > 10000) {
+    logf("Missed %lu frame deadlines", _missed - _missedLogged);
+    _missedLogged = _missed;
+    _lastMissLog = millis();
+  }
+}
+
+#endif // FRAMESCHEDULER_H
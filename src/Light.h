@@ -1,3 +1,5 @@
+#ifndef LIGHT_H
+#define LIGHT_H
 
 #if FAST_LED
 #include "FastLED.h"
@@ -21,95 +23,77 @@ typedef enum {
 } LightTransitionCurve;
 
 
-class Light {
+// All the strand's lights, stored as parallel channel arrays so the per-frame
+// loops walk memory linearly instead of chasing a pointer per light.
+// Fades live in TransitionEngine (Transitions.h), which writes into color.
+//
+// Each light has a dirty bit so the strand update only reprocesses lights that
+// changed since the last one. Write colors through setColor(), which sets it.
+class Lights {
 public:
-  Light();
+  Lights(unsigned int count);
+  ~Lights();
   
-  Color color;
-  Color targetColor;
-  Color originalColor;
+  unsigned int count;
   
-  unsigned long duration; // in millis
-  unsigned long transitionStart;
-  LightTransitionCurve curve;
+  Color *color;
+  uint8_t *modeState; // For the Scene mode to use to store state
   
-  void transitionToColor(Color transitionTargetColor, int durationMillis, LightTransitionCurve curve);
-  void transitionToColor(Color transitionTargetColor, int durationMillis);
-  void stopTransition();
-  void transitionTick(unsigned long milliseconds);
-  bool isTransitioning();
-  void printDescription();
+  void setColor(unsigned int index, Color c) {
+    Color& current = color[index];
+    if (current.red != c.red || current.green != c.green || current.blue != c.blue) {
+      current = c;
+      markDirty(index);
+    }
+  }
   
-  int modeState; // For the Scene mode to use to store state
-};
-
-Light::Light() : duration(0), transitionStart(0)
-{
-}
-
-// FIXME: Add a special transition mode which ignores global speed, use for lightning bugs, power switch, etc.
-
-void Light::transitionToColor(Color transitionTargetColor, int durationMillis, LightTransitionCurve curve)
-{
-  if (durationMillis <= 0) {
-    durationMillis = 1;
+  void markDirty(unsigned int index) {
+    dirty[index >> 3] |= (1 << (index & 7));
+    _anyDirty = true;
   }
-  targetColor = transitionTargetColor;
-  originalColor = color;
-  duration = durationMillis;
-  transitionStart = millis();
-  curve = curve;
-}
-
-void Light::transitionToColor(Color transitionTargetColor, int durationMillis)
-{
-  transitionToColor(transitionTargetColor, durationMillis, LightTransitionLinear);
-}
-
-void Light::stopTransition()
-{
-  transitionStart = 0;
-}
-
-void Light::transitionTick(unsigned long milliseconds)
-{
-  if (isTransitioning()) {
-    uint8_t progress = min((uint8_t)0xFF, 0xFF * (millis() - transitionStart) / duration);
-    uint8_t curvedTransitionProgress = progress;
-    
-    switch (curve) {
-      case LightTransitionLinear:
-        break;
-      case LightTransitionEaseInOut:
-        curvedTransitionProgress = ease8InOutQuad(progress);
-        break;
-    }
-    
-    color.red = lerp8by8(originalColor.red, targetColor.red,  curvedTransitionProgress);
-    color.green = lerp8by8(originalColor.green, targetColor.green, curvedTransitionProgress);
-    color.blue = lerp8by8(originalColor.blue, targetColor.blue, curvedTransitionProgress);
-    
-    if (progress == 0xFF) {
-      if (!ColorIsEqualToColor(color, targetColor)) {
-        logf("Not equal!, progress = %u, curvedprogress = %u, color = (%i, %i, %i)", progress, curvedTransitionProgress, (int)color.red, (int)color.green, (int)color.blue);
-      }
-      transitionStart = 0;
-    }
+  bool isDirty(unsigned int index) {
+    return dirty[index >> 3] & (1 << (index & 7));
   }
-}
+  bool anyDirty() {
+    return _anyDirty;
+  }
+  // Only the light's bit. anyDirty() stays true until the clearDirty() below.
+  void clearDirty(unsigned int index) {
+    dirty[index >> 3] &= ~(1 << (index & 7));
+  }
+  void clearDirty() {
+    memset(dirty, 0, (count + 7) / 8);
+    _anyDirty = false;
+  }
+  
+private:
+  uint8_t *dirty; // one bit per light
+  bool _anyDirty;
+  void *storage;
+};
 
-bool Light::isTransitioning()
+Lights::Lights(unsigned int count) : count(count)
 {
-  return (transitionStart != 0);
+  const size_t dirtyBytes = (count + 7) / 8;
+  size_t perLight = sizeof(Color) + sizeof(uint8_t);
+  storage = malloc(count * perLight + dirtyBytes);
+  memset(storage, 0, count * perLight);
+  
+  uint8_t *p = (uint8_t *)storage;
+  color = (Color *)p;
+  p += count * sizeof(Color);
+  modeState = p;
+  p += count * sizeof(uint8_t);
+  dirty = p;
+  
+  // Everything gets sent the first time
+  memset(dirty, 0xFF, dirtyBytes);
+  _anyDirty = true;
 }
 
-void Light::printDescription()
+Lights::~Lights()
 {
-  char buf[20];
-  snprintf(buf, 20, "%p", this);
-  Serial.print("<Light ");
-  Serial.print(buf);
-  Serial.print(" isTransitioning = ");
-  Serial.print(isTransitioning() ? "yes" : "no");
-  Serial.print(">");
+  free(storage);
 }
+
+#endif // LIGHT_H
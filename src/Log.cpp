@@ -0,0 +1,237 @@
+#include "stdarg.h"
+
+#include "Arduino.h"
+#include "Config.h"
+#include "Log.h"
+
+// Each record in the ring is [format id][argument byte count][packed arguments]
+static uint8_t sRing[LOG_BUFFER_BYTES];
+static uint16_t sHead = 0; // next byte written
+static uint16_t sTail = 0; // next byte drained
+static uint16_t sUsed = 0;
+
+static const char *sFormats[LOG_MAX_FORMATS];
+static uint8_t sFormatCount = 0;
+#if LOG_BINARY
+static uint8_t sFormatSent[(LOG_MAX_FORMATS + 7) / 8];
+#endif
+
+static unsigned long sDropped = 0;
+static unsigned long sDroppedUnreported = 0;
+
+static int formatId(const char *format)
+{
+  for (uint8_t i = 0; i < sFormatCount; ++i) {
+    if (sFormats[i] == format) {
+      return i;
+    }
+  }
+  if (sFormatCount == LOG_MAX_FORMATS) {
+    return -1;
+  }
+  sFormats[sFormatCount] = format;
+  return sFormatCount++;
+}
+
+static uint8_t packArguments(uint8_t *out, const char *format, va_list args)
+{
+  uint8_t used = 0;
+  for (const char *p = format; *p; ) {
+    if (*p != '%') {
+      ++p;
+      continue;
+    }
+    const char *end;
+    char conversion = logParseSpec(p, &end);
+    uint8_t longs = 0;
+    bool isSize = false;
+    for (; p < end; ++p) {
+      longs += (*p == 'l');
+      isSize |= (*p == 'z');
+    }
+
+    if (conversion == '%' || conversion == '\0') {
+      continue;
+    }
+    if (conversion == 's') {
+      const char *string = va_arg(args, const char *);
+      if (!string) {
+        string = "(null)";
+      }
+      size_t length = strnlen(string, kLogMaxStringBytes);
+      if (used + length + 1 > kLogMaxArgBytes) {
+        break;
+      }
+      memcpy(out + used, string, length);
+      out[used + length] = '\0';
+      used += length + 1;
+      continue;
+    }
+    if (used + 4 > kLogMaxArgBytes) {
+      break;
+    }
+    uint32_t value;
+    if (strchr("fFeEgGaA", conversion)) {
+      float f = va_arg(args, double);
+      memcpy(&value, &f, sizeof(value));
+    } else if (conversion == 'p') {
+      value = (uintptr_t)va_arg(args, void *);
+    } else if (isSize) {
+      value = va_arg(args, size_t);
+    } else if (longs > 1) {
+      value = va_arg(args, long long); // only the low 32 bits survive
+    } else if (longs == 1) {
+      value = va_arg(args, long);
+    } else {
+      value = va_arg(args, int);
+    }
+    logPackInt(out + used, value);
+    used += 4;
+  }
+  return used;
+}
+
+static void ringWrite(const uint8_t *bytes, uint8_t count)
+{
+  for (uint8_t i = 0; i < count; ++i) {
+    sRing[sHead] = bytes[i];
+    sHead = (sHead + 1) % LOG_BUFFER_BYTES;
+  }
+  sUsed += count;
+}
+
+// Read without draining, from offset bytes past the tail
+static void ringPeek(uint8_t offset, uint8_t *bytes, uint8_t count)
+{
+  for (uint8_t i = 0; i < count; ++i) {
+    bytes[i] = sRing[(sTail + offset + i) % LOG_BUFFER_BYTES];
+  }
+}
+
+static void ringSkip(uint8_t count)
+{
+  sTail = (sTail + count) % LOG_BUFFER_BYTES;
+  sUsed -= count;
+}
+
+void logf(const char *format, ...)
+{
+  uint8_t args[kLogMaxArgBytes];
+  va_list argptr;
+  va_start(argptr, format);
+  uint8_t argBytes = packArguments(args, format, argptr);
+  va_end(argptr);
+
+  int id = formatId(format);
+  if (id < 0 || sUsed + 2 + argBytes > LOG_BUFFER_BYTES) {
+    ++sDropped;
+    ++sDroppedUnreported;
+    return;
+  }
+  const uint8_t header[2] = {(uint8_t)id, argBytes};
+  ringWrite(header, 2);
+  ringWrite(args, argBytes);
+}
+
+// The most Serial.availableForWrite() has reported, which is its whole
+// transmit buffer once it's been seen empty
+static int sSerialCapacity = 0;
+
+// Whether Serial can take bytes without blocking. A message longer than the
+// buffer waits for it to empty rather than for room it will never have. Where
+// Serial doesn't know (availableForWrite() is always 0), everything goes.
+static bool serialCanTake(unsigned int bytes)
+{
+  const int available = Serial.availableForWrite();
+  if (available > sSerialCapacity) {
+    sSerialCapacity = available;
+  }
+  return available >= (bytes < (unsigned int)sSerialCapacity ? (int)bytes : sSerialCapacity);
+}
+
+static bool reportDropped()
+{
+  const uint16_t count = (sDroppedUnreported > 0xFFFF ? 0xFFFF : sDroppedUnreported);
+#if LOG_BINARY
+  const uint8_t record[] = {kLogRecordMark, LogRecordDropped, (uint8_t)count, (uint8_t)(count >> 8)};
+  if (!serialCanTake(sizeof(record))) {
+    return false;
+  }
+  Serial.write(record, sizeof(record));
+#else
+  char line[40];
+  snprintf(line, sizeof(line), "(%u log messages dropped)", (unsigned)count);
+  if (!serialCanTake(strlen(line) + 2)) {
+    return false;
+  }
+  Serial.println(line);
+#endif
+  sDroppedUnreported = 0;
+  return true;
+}
+
+// Writes out the oldest message, unless Serial would block on it
+static bool drainOne()
+{
+  uint8_t header[2];
+  uint8_t args[kLogMaxArgBytes];
+  ringPeek(0, header, 2);
+  const uint8_t id = header[0], argBytes = header[1];
+  ringPeek(2, args, argBytes);
+
+#if LOG_BINARY
+  const bool sendFormat = !(sFormatSent[id / 8] & (1 << (id % 8)));
+  if (!serialCanTake(4 + argBytes + (sendFormat ? 3 + strlen(sFormats[id]) + 1 : 0))) {
+    return false;
+  }
+  if (sendFormat) {
+    const uint8_t define[] = {kLogRecordMark, LogRecordFormat, id};
+    Serial.write(define, sizeof(define));
+    Serial.write((const uint8_t *)sFormats[id], strlen(sFormats[id]) + 1);
+    sFormatSent[id / 8] |= (1 << (id % 8));
+  }
+  const uint8_t message[] = {kLogRecordMark, LogRecordMessage, id, argBytes};
+  Serial.write(message, sizeof(message));
+  Serial.write(args, argBytes);
+#else
+  char line[128];
+  logFormatPacked(line, sizeof(line), sFormats[id], args, argBytes);
+  if (!serialCanTake(strlen(line) + 2)) {
+    return false;
+  }
+  Serial.println(line);
+#endif
+  ringSkip(2 + argBytes);
+  return true;
+}
+
+bool logDrain(unsigned long budgetMicros)
+{
+  const unsigned long start = micros();
+  while (micros() - start < budgetMicros) {
+    if (sUsed == 0) {
+      // The drops came after everything that was buffered
+      if (sDroppedUnreported) {
+        reportDropped();
+      }
+      break;
+    }
+    if (!drainOne()) {
+      break; // until Serial has sent some of what it has
+    }
+  }
+  return sUsed > 0 || sDroppedUnreported;
+}
+
+void logFlush()
+{
+  while (sUsed > 0 || sDroppedUnreported) {
+    logDrain(0xFFFFFFFF);
+  }
+  Serial.flush();
+}
+
+unsigned long logDroppedCount()
+{
+  return sDropped;
+}
@@ -0,0 +1,141 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// logf() doesn't format or print anything. It looks up a small id for the
+// format string (by address, so formats need to be literals), packs the raw
+// arguments after it into a fixed ring buffer and returns. logDrain() does the
+// formatting and the Serial writes later, in whatever time the frame didn't
+// need. When the ring is full the message is dropped and counted, and the
+// next drain reports how many went missing.
+//
+// With LOG_BINARY the drain sends the packed records as they are, and each
+// format string once, the first time it's used, which is far fewer bytes over
+// a slow serial link. native/logdecode.cpp expands the stream back into text.
+
+void logf(const char *format, ...);
+
+// Write out buffered messages for up to budgetMicros, and only as many as
+// Serial can take without blocking. With no budget nothing goes out, so late
+// frames don't get later; the ring fills and drops instead. True if messages
+// are still waiting.
+bool logDrain(unsigned long budgetMicros);
+// Write out everything now, e.g. before halting
+void logFlush();
+unsigned long logDroppedCount();
+
+/* Packed arguments */
+
+// Shared with the host decoder. Integers of any size are packed as 4 bytes,
+// floating point as a 4 byte float and strings as their bytes plus a NUL, all
+// little-endian, so the stream reads the same whatever the board's int size.
+
+static const uint8_t kLogMaxArgBytes = 48;
+static const uint8_t kLogMaxStringBytes = 24; // longer strings are cut off
+
+// Binary stream records, each starting with kLogRecordMark, which never
+// appears in the ASCII text a board prints
+static const uint8_t kLogRecordMark = 0xA5;
+enum {
+  LogRecordFormat = 1, // id, format string, NUL
+  LogRecordMessage = 2, // id, argument byte count, packed arguments
+  LogRecordDropped = 3, // count dropped since the last report, 2 bytes
+};
+
+// Finds the conversion at format[0] == '%'. Returns the conversion character
+// ('%' for a literal percent) and sets *end past it.
+inline char logParseSpec(const char *format, const char **end)
+{
+  const char *p = format + 1;
+  while (*p && strchr("-+ #0123456789.hlzjtL", *p)) {
+    ++p;
+  }
+  *end = (*p ? p + 1 : p);
+  return *p;
+}
+
+inline void logPackInt(uint8_t *out, uint32_t v)
+{
+  out[0] = v;
+  out[1] = v >> 8;
+  out[2] = v >> 16;
+  out[3] = v >> 24;
+}
+
+inline uint32_t logUnpackInt(const uint8_t *in)
+{
+  return in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// Expand a format and its packed arguments into out, like snprintf
+inline void logFormatPacked(char *out, size_t outSize, const char *format, const uint8_t *args, uint8_t argBytes)
+{
+  size_t used = 0;
+  uint8_t argOffset = 0;
+  const char *p = format;
+  while (*p && used + 1 < outSize) {
+    if (*p != '%') {
+      out[used++] = *p++;
+      continue;
+    }
+    const char *end;
+    char conversion = logParseSpec(p, &end);
+
+    // The spec without its length modifiers, to put back what the packed size needs
+    char spec[16];
+    size_t specLength = 0;
+    for (const char *s = p; s < end - 1 && specLength < sizeof(spec) - 3; ++s) {
+      if (!strchr("hlzjtL", *s)) {
+        spec[specLength++] = *s;
+      }
+    }
+
+    size_t room = outSize - used;
+    int written = 0;
+    if (conversion == '%') {
+      written = snprintf(out + used, room, "%%");
+    } else if (conversion == 's') {
+      const char *string = (argOffset < argBytes ? (const char *)args + argOffset : "");
+      spec[specLength++] = 's';
+      spec[specLength] = '\0';
+      written = snprintf(out + used, room, spec, string);
+      argOffset += strnlen(string, argBytes - argOffset) + 1;
+    } else if (argOffset + 4 > argBytes) {
+      written = snprintf(out + used, room, "?");
+    } else if (strchr("fFeEgGaA", conversion)) {
+      uint32_t bits = logUnpackInt(args + argOffset);
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      spec[specLength++] = conversion;
+      spec[specLength] = '\0';
+      written = snprintf(out + used, room, spec, (double)value);
+      argOffset += 4;
+    } else if (conversion == 'c') {
+      spec[specLength++] = 'c';
+      spec[specLength] = '\0';
+      written = snprintf(out + used, room, spec, (int)(char)logUnpackInt(args + argOffset));
+      argOffset += 4;
+    } else {
+      uint32_t value = logUnpackInt(args + argOffset);
+      spec[specLength++] = 'l';
+      spec[specLength++] = (conversion == 'p' ? 'x' : conversion);
+      spec[specLength] = '\0';
+      if (conversion == 'd' || conversion == 'i') {
+        written = snprintf(out + used, room, spec, (long)(int32_t)value);
+      } else {
+        written = snprintf(out + used, room, spec, (unsigned long)value);
+      }
+      argOffset += 4;
+    }
+    if (written > 0) {
+      used += ((size_t)written < room ? (size_t)written : room - 1);
+    }
+    p = end;
+  }
+  out[used] = '\0';
+}
+
+#endif // LOG_H
@@ -0,0 +1,180 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <FastLED.h>
+#include "Config.h"
+#include "WS2811.h"
+
+#if ARDUINO_TCL
+#include <TCL.h>
+#endif
+
+// Where finished frames go. Scene::updateStrand() writes pixels() and calls
+// present() once per frame that changed anything.
+//
+// A double-buffered driver sends from a front buffer of its own: present()
+// waits for the previous frame to finish going out, snapshots pixels() into
+// the front buffer, starts sending and returns, so the scene computes the next
+// frame while this one is on the wire. That only pays off when the driver
+// really sends in the background (DMA, a second core, the host's mock), so the
+// bit-banged drivers below are single-buffered and present() blocks until sent.
+class OutputDriver {
+public:
+  OutputDriver(unsigned int count, bool doubleBuffered);
+  virtual ~OutputDriver();
+
+  const unsigned int count;
+
+  // The frame being built. Pixels keep their values from one frame to the next.
+  CRGB *pixels() {
+    return _back;
+  }
+
+  void present();
+
+  // True while the last presented frame is still being sent
+  virtual bool isSending() {
+    return false;
+  }
+
+  // The physical strands, as runs of pixels() (see PixelMap.h)
+  uint8_t strandCount() {
+    return _strandCount;
+  }
+  unsigned int strandStart(uint8_t strand) {
+    return _strandStart[strand];
+  }
+  unsigned int strandLength(uint8_t strand) {
+    return _strandLength[strand];
+  }
+
+protected:
+  CRGB *_back;
+  CRGB *_front; // same as _back when single-buffered
+
+  static const uint8_t kMaxStrands = 4;
+  uint16_t _strandStart[kMaxStrands];
+  uint16_t _strandLength[kMaxStrands];
+  uint8_t _strandCount = 0;
+
+  void addStrand(uint16_t start, uint16_t length) {
+    if (_strandCount < kMaxStrands) {
+      _strandStart[_strandCount] = start;
+      _strandLength[_strandCount] = length;
+      ++_strandCount;
+    }
+  }
+
+  // Start sending _front, which stays untouched until the send is done
+  virtual void send() = 0;
+  virtual void waitUntilSent() {}
+};
+
+inline OutputDriver::OutputDriver(unsigned int count, bool doubleBuffered) : count(count)
+{
+  _back = (CRGB *)malloc(count * sizeof(CRGB));
+  memset((void *)_back, 0, count * sizeof(CRGB));
+  _front = _back;
+  if (doubleBuffered) {
+    _front = (CRGB *)malloc(count * sizeof(CRGB));
+    memset((void *)_front, 0, count * sizeof(CRGB));
+  }
+}
+
+inline OutputDriver::~OutputDriver()
+{
+  if (_front != _back) {
+    free(_front);
+  }
+  free(_back);
+}
+
+inline void OutputDriver::present()
+{
+  waitUntilSent();
+  if (_front != _back) {
+    memcpy((void *)_front, _back, count * sizeof(CRGB));
+  }
+  send();
+}
+
+/* Board drivers */
+
+#if MEGA_WS2811
+
+class WS2811Output : public OutputDriver {
+public:
+  WS2811Output(unsigned int count) : OutputDriver(count, false), _renderer(count, (uint8_t *)_front) {
+    addStrand(0, count);
+  }
+
+protected:
+  WS2811Renderer _renderer; // CRGB is laid out as the renderer's RGB bytes
+
+  void send() {
+    _renderer.render();
+  }
+};
+
+#elif ARDUINO_TCL
+
+class TCLOutput : public OutputDriver {
+public:
+  TCLOutput(unsigned int count) : OutputDriver(count, false) {
+    addStrand(0, count);
+  }
+
+protected:
+  void send() {
+    TCL.sendEmptyFrame();
+    for (unsigned int i = 0; i < count; ++i) {
+      TCL.sendColor(_front[i].r, _front[i].g, _front[i].b);
+    }
+    TCL.sendEmptyFrame();
+  }
+};
+
+#elif FAST_LED
+
+// FastLED's clockless show() holds the CPU until the last bit is out, so there
+// is nothing to overlap with and a second buffer would only cost RAM.
+class FastLEDOutput : public OutputDriver {
+public:
+  FastLEDOutput(unsigned int count) : OutputDriver(count, false) {
+#ifdef FAST_LED_PIN_2
+    LEDS.addLeds<FASTLED_PIXEL_TYPE, FAST_LED_PIN_1, RGB>(_front, count/2, count/2);
+    addStrand(count/2, count/2);
+    LEDS.addLeds<FASTLED_PIXEL_TYPE, FAST_LED_PIN_2, RGB>(_front, count/2);
+    addStrand(0, count/2);
+#elif FAST_LED_PIN_1
+    LEDS.addLeds<FASTLED_PIXEL_TYPE, FAST_LED_PIN_1, RGB>(_front, count);
+    addStrand(0, count);
+#else
+    LEDS.addLeds<FASTLED_PIXEL_TYPE, RGB>(_front, count);
+    addStrand(0, count);
+#endif
+    // Color correction happens before pixels get here (ColorCorrection.h)
+    LEDS.setBrightness(0xFF);
+  }
+
+protected:
+  void send() {
+    FastLED.show();
+  }
+};
+
+#endif
+
+// The driver for this board's strand
+static inline OutputDriver *createOutputDriver(unsigned int count)
+{
+#if MEGA_WS2811
+  return new WS2811Output(count);
+#elif ARDUINO_TCL
+  return new TCLOutput(count);
+#elif FAST_LED
+  return new FastLEDOutput(count);
+#endif
+}
+
+#endif // OUTPUT_H
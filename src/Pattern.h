@@ -0,0 +1,121 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#if MEGA
+#include <new.h>
+#else
+#include <new>
+#endif
+
+#include "Config.h"
+#include "Color.h"
+#include "Light.h"
+#include "Transitions.h"
+#include "FrameClock.h"
+#include "ColorMaker.h"
+#include "Arena.h"
+#include "Random.h"
+#include "palettes.h"
+
+typedef enum {
+  ModeWaves,
+  ModeFire,
+  ModeBlueFire,
+  ModeGreenFire,
+  ModePinkFire,
+  ModeLightningBugs,
+  ModeParity,
+  ModeInterferingWaves,
+  ModeRainbow,
+  ModeAccumulator,
+  ModeTwinkle,
+  ModeBoomResponder,
+  ModeBounce,
+  ModeCount, // every mode, registered or not
+} Mode;
+
+// "Follow" convenience counter: a position that travels around the strand on
+// its own, which patterns can chase
+struct Follower {
+  float leader;
+  int speed; // number of lights / s that the leader moves
+  bool reversed;
+};
+
+// Everything the Scene lends a pattern. The pattern must not hold on to any of
+// it past end().
+struct PatternContext {
+  unsigned int lightCount;
+  Lights& lights;
+  TransitionEngine& transitions;
+  const FrameClock& clock;
+  ColorMaker& colorMaker; // prepped with no colors until begin() asks for some
+  PaletteRotation<CRGBPalette256>& palette;
+  Arena& arena; // what the pattern allocates here goes away with the pattern
+  Follower& follow;
+  const uint32_t& modeStart; // wall time
+  RandomStream& random; // the pattern's own, reseeded from gRandom when its mode starts
+
+  unsigned long modeTime() {
+    return clock.realNow() - modeStart;
+  }
+
+  void transitionAll(Color c, int durationMillis) {
+    for (unsigned int i = 0; i < lightCount; ++i) {
+      transitions.transitionToColor(i, c, durationMillis);
+    }
+  }
+};
+
+// One mode's animation and whatever state it keeps between frames. Patterns
+// are built into the mode arena when their mode starts and destroyed when it
+// ends, so anything sized by the strand comes from ctx.arena in begin(), and
+// arenaBytes() has to say how much.
+class Pattern {
+public:
+  virtual ~Pattern() {}
+
+  virtual void begin(PatternContext& ctx) {}
+  virtual void tick(PatternContext& ctx) = 0;
+  // Before the next pattern begins. e.g. to start fading out.
+  virtual void end(PatternContext& ctx) {}
+
+  // Patterns that only start fades can get by on fewer frames
+  virtual unsigned int framesPerSecond() {
+    return FRAMES_PER_SECOND;
+  }
+
+  // Bytes begin() takes from the arena, not counting the pattern itself. Each
+  // alloc() counts as Arena::bytes() of its size.
+  static size_t arenaBytes(unsigned int lightCount) {
+    return 0;
+  }
+};
+
+/* Registry */
+
+// The patterns built into this deployment are listed in kPatterns
+// (PatternRegistry.h), each behind its PATTERN_* flag from Config.h
+struct PatternEntry {
+  Mode mode;
+  Pattern *(*create)(Arena& arena);
+  size_t (*arenaBytes)(unsigned int lightCount); // the pattern itself included
+  bool inRotation; // chosen by Scene::randomMode()
+};
+
+template <class T>
+Pattern *createPattern(Arena& arena)
+{
+  void *storage = arena.alloc(sizeof(T));
+  return (storage ? new (storage) T() : NULL);
+}
+
+template <class T>
+size_t patternArenaBytes(unsigned int lightCount)
+{
+  return Arena::bytes(sizeof(T)) + T::arenaBytes(lightCount);
+}
+
+#define PATTERN_ENTRY(mode, T, inRotation) {mode, createPattern<T>, patternArenaBytes<T>, inRotation}
+
+#endif // PATTERN_H
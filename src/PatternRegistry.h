@@ -0,0 +1,87 @@
+#ifndef PATTERNREGISTRY_H
+#define PATTERNREGISTRY_H
+
+#include "Config.h"
+#include "Pattern.h"
+
+#if PATTERN_WAVES
+#include "patterns/Waves.h"
+#endif
+#if PATTERN_FIRE
+#include "patterns/Fire.h"
+#endif
+#if PATTERN_LIGHTNING_BUGS
+#include "patterns/LightningBugs.h"
+#endif
+#if PATTERN_PARITY
+#include "patterns/Parity.h"
+#endif
+#if PATTERN_INTERFERING_WAVES
+#include "patterns/InterferingWaves.h"
+#endif
+#if PATTERN_RAINBOW
+#include "patterns/Rainbow.h"
+#endif
+#if PATTERN_ACCUMULATOR
+#include "patterns/Accumulator.h"
+#endif
+#if PATTERN_TWINKLE
+#include "patterns/Twinkle.h"
+#endif
+#if PATTERN_BOOM_RESPONDER
+#include "patterns/BoomResponder.h"
+#endif
+#if PATTERN_BOUNCE
+#include "patterns/Bounce.h"
+#endif
+
+// Every pattern built into this deployment. A pattern left out by its flag
+// costs no flash or RAM; Scene::setMode() to its mode just goes dark.
+static const PatternEntry kPatterns[] = {
+#if PATTERN_WAVES
+  PATTERN_ENTRY(ModeWaves, WavesPattern, true),
+#endif
+#if PATTERN_FIRE
+  PATTERN_ENTRY(ModeFire, FirePattern, true),
+  PATTERN_ENTRY(ModeBlueFire, BlueFirePattern, true),
+  PATTERN_ENTRY(ModeGreenFire, GreenFirePattern, true),
+  PATTERN_ENTRY(ModePinkFire, PinkFirePattern, true),
+#endif
+#if PATTERN_LIGHTNING_BUGS
+  PATTERN_ENTRY(ModeLightningBugs, LightningBugsPattern, true),
+#endif
+#if PATTERN_PARITY
+  PATTERN_ENTRY(ModeParity, ParityPattern, true),
+#endif
+#if PATTERN_INTERFERING_WAVES
+  PATTERN_ENTRY(ModeInterferingWaves, InterferingWavesPattern, true),
+#endif
+#if PATTERN_RAINBOW
+  PATTERN_ENTRY(ModeRainbow, RainbowPattern, true),
+#endif
+#if PATTERN_ACCUMULATOR
+  PATTERN_ENTRY(ModeAccumulator, AccumulatorPattern, true),
+#endif
+  // These are all either boring or need work, so they stay out of rotation
+#if PATTERN_TWINKLE
+  PATTERN_ENTRY(ModeTwinkle, TwinklePattern, false),
+#endif
+#if PATTERN_BOOM_RESPONDER
+  PATTERN_ENTRY(ModeBoomResponder, BoomResponderPattern, false),
+#endif
+#if PATTERN_BOUNCE
+  PATTERN_ENTRY(ModeBounce, BouncePattern, false),
+#endif
+};
+
+static const PatternEntry *patternForMode(Mode mode)
+{
+  for (unsigned int i = 0; i < ARRAY_SIZE(kPatterns); ++i) {
+    if (kPatterns[i].mode == mode) {
+      return &kPatterns[i];
+    }
+  }
+  return NULL;
+}
+
+#endif // PATTERNREGISTRY_H
@@ -0,0 +1,145 @@
+#ifndef PIXELMAP_H
+#define PIXELMAP_H
+
+#include "Config.h"
+#include "Output.h"
+#include "ColorCorrection.h"
+
+// Where each light physically sits on the strands. A layout is a list of
+// segments, each a run of pixels on one strand that the next lights fill, in
+// order, optionally from the far end. Pixels no segment covers (gaps) and dead
+// pixels are skipped over and stay dark. A segment can also pick its own color
+// profile (ColorCorrection.h).
+//
+// The layout gets resolved once into a table from light index to position in
+// the output buffer, which updateStrand() writes through, so any layout costs
+// the same per frame. Without a layout lights map straight through and there's
+// no table at all.
+
+struct PixelSegment {
+  uint8_t strand;
+  uint16_t first; // first pixel on the strand
+  uint16_t length; // pixels covered, including dead ones
+  bool reversed; // lights run from first + length - 1 down to first
+  uint8_t profile; // index into kColorProfiles
+};
+
+struct PixelAddress {
+  uint8_t strand;
+  uint16_t pixel;
+};
+
+/* Layouts */
+
+#ifdef FAST_LED_PIN_2
+// Two strands running out from the middle. Pin 2's strand comes first, then
+// pin 1's runs back the other way so the pattern stays continuous.
+#define PIXEL_LAYOUT 1
+static const PixelSegment kPixelLayout[] = {
+  {1, 0, LED_COUNT/2, false},
+  {0, 0, LED_COUNT/2, true},
+};
+#endif
+
+// Pixels that are broken or hidden, skipped over by the layout. e.g.:
+// #define DEAD_PIXELS 1
+// static const PixelAddress kDeadPixels[] = {{0, 17}};
+
+/* --- */
+
+class PixelMap {
+public:
+  static const uint16_t kUnmapped = 0xFFFF;
+
+  PixelMap() : _table(NULL), _profiles(NULL) {}
+  ~PixelMap() {
+    free(_table);
+    free(_profiles);
+  }
+
+  // Resolve the layout above for `lightCount` lights onto `output`'s strands
+  void resolve(unsigned int lightCount, OutputDriver& output);
+
+  // Position in the output buffer, or kUnmapped for a light the layout leaves out
+  uint16_t map(unsigned int light) {
+    return (_table ? _table[light] : light);
+  }
+
+  // The light's color profile
+  uint8_t profile(unsigned int light) {
+    return (_profiles ? _profiles[light] : 0);
+  }
+
+private:
+  uint16_t *_table;
+  uint8_t *_profiles; // only when some segment has a profile of its own
+
+  void resolve(unsigned int lightCount, OutputDriver& output, const PixelSegment *segments, unsigned int segmentCount,
+               const PixelAddress *dead, unsigned int deadCount);
+};
+
+void PixelMap::resolve(unsigned int lightCount, OutputDriver& output)
+{
+#if PIXEL_LAYOUT && DEAD_PIXELS
+  resolve(lightCount, output, kPixelLayout, ARRAY_SIZE(kPixelLayout), kDeadPixels, ARRAY_SIZE(kDeadPixels));
+#elif PIXEL_LAYOUT
+  resolve(lightCount, output, kPixelLayout, ARRAY_SIZE(kPixelLayout), NULL, 0);
+#elif DEAD_PIXELS
+  const PixelSegment everything = {0, 0, (uint16_t)output.count, false};
+  resolve(lightCount, output, &everything, 1, kDeadPixels, ARRAY_SIZE(kDeadPixels));
+#endif
+}
+
+void PixelMap::resolve(unsigned int lightCount, OutputDriver& output, const PixelSegment *segments, unsigned int segmentCount,
+                       const PixelAddress *dead, unsigned int deadCount)
+{
+  free(_table);
+  _table = (uint16_t *)malloc(lightCount * sizeof(uint16_t));
+  free(_profiles);
+  _profiles = NULL;
+  for (unsigned int s = 0; s < segmentCount; ++s) {
+    assert(segments[s].profile < ARRAY_SIZE(kColorProfiles), "PixelMap: segment has a color profile that doesn't exist");
+    if (segments[s].profile != 0 && !_profiles) {
+      _profiles = (uint8_t *)malloc(lightCount);
+      memset(_profiles, 0, lightCount);
+    }
+  }
+
+  unsigned int light = 0;
+  for (unsigned int s = 0; s < segmentCount && light < lightCount; ++s) {
+    const PixelSegment& segment = segments[s];
+    assert(segment.strand < output.strandCount(), "PixelMap: segment on a strand the output doesn't have");
+    assert(segment.first + segment.length <= output.strandLength(segment.strand), "PixelMap: segment runs off the end of its strand");
+    if (segment.strand >= output.strandCount()) {
+      continue;
+    }
+    const unsigned int start = output.strandStart(segment.strand);
+    const unsigned int length = min((unsigned int)segment.length, output.strandLength(segment.strand) - min((unsigned int)segment.first, output.strandLength(segment.strand)));
+
+    for (unsigned int p = 0; p < length && light < lightCount; ++p) {
+      const uint16_t pixel = segment.first + (segment.reversed ? length - 1 - p : p);
+      bool isDead = false;
+      for (unsigned int d = 0; d < deadCount; ++d) {
+        if (dead[d].strand == segment.strand && dead[d].pixel == pixel) {
+          isDead = true;
+          break;
+        }
+      }
+      if (!isDead) {
+        if (_profiles) {
+          _profiles[light] = (segment.profile < ARRAY_SIZE(kColorProfiles) ? segment.profile : 0);
+        }
+        _table[light++] = start + pixel;
+      }
+    }
+  }
+
+  if (light < lightCount) {
+    logf("PixelMap: layout only places %u of %u lights", light, lightCount);
+  }
+  for (; light < lightCount; ++light) {
+    _table[light] = kUnmapped;
+  }
+}
+
+#endif // PIXELMAP_H
@@ -0,0 +1,201 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "Config.h"
+#include "Pattern.h"
+
+// Times each stage of a frame, per mode. Scene::tick() marks where each stage
+// ends with PROFILE_LAP(); everything compiles away unless PROFILING is on.
+//
+// Each stage keeps a count, min, max, mean and a histogram of durations in
+// power-of-two microsecond buckets, which p99 is read from (as the top of the
+// bucket it lands in). Send 'p' over Serial for a report and 'r' to start
+// over. The host bench uses the same hooks when built with LIGHTS_PROFILING.
+//
+// The Mega only has room for one mode's stats, so there they cover the
+// current mode and start over when it changes.
+
+typedef enum {
+  ProfileTransitions,
+  ProfilePalette,
+  ProfileColorMaker,
+  ProfileMode,
+  ProfileConvert, // updateStrand() turning lights into pixels
+  ProfileShow, // handing the frame to the output
+  ProfileFrame, // all of Scene::tick()
+  ProfileStageCount,
+} ProfileStage;
+
+#if PROFILING
+
+#if NATIVE
+// The scene runs on a virtual clock on the host
+#define profileMicros() nativeRealMicros()
+#else
+#define profileMicros() micros()
+#endif
+
+// Bucket b counts durations under 2^((b + 1) * kProfileBucketScale) us
+#if MEGA
+#define PROFILE_BUCKETS 8
+static const uint8_t kProfileBucketScale = 2;
+static const unsigned int kProfiledModeCount = 1;
+#else
+#define PROFILE_BUCKETS 16
+static const uint8_t kProfileBucketScale = 1;
+static const unsigned int kProfiledModeCount = ModeCount;
+#endif
+
+struct ProfileStats {
+  unsigned long count;
+  unsigned long totalMicros;
+  unsigned long minMicros;
+  unsigned long maxMicros;
+  uint16_t buckets[PROFILE_BUCKETS]; // saturating
+
+  void record(unsigned long elapsed);
+  unsigned long percentile(uint8_t percent);
+};
+
+class Profiler {
+public:
+  Profiler() {
+    reset();
+  }
+
+  void setMode(Mode mode) {
+    _mode = mode;
+    if (kProfiledModeCount == 1) {
+      reset();
+    }
+  }
+  void record(ProfileStage stage, unsigned long elapsed) {
+    if ((unsigned)_mode < ModeCount) {
+      _stats[slot(_mode)][stage].record(elapsed);
+    }
+  }
+  // Only the current mode's on the Mega
+  ProfileStats& stats(Mode mode, ProfileStage stage) {
+    return _stats[slot(mode)][stage];
+  }
+
+  void reset();
+  // Check Serial for a report or reset request
+  void poll();
+  // Modes that have run since the last reset, one line per stage
+  void report();
+
+private:
+  Mode _mode = (Mode)-1;
+  ProfileStats _stats[kProfiledModeCount][ProfileStageCount];
+
+  static unsigned int slot(Mode mode) {
+    return (kProfiledModeCount == 1 ? 0 : mode);
+  }
+};
+
+Profiler gProfiler;
+
+static const char *const kProfileStageNames[ProfileStageCount] = {"transitions", "palette", "colors", "mode", "convert", "show", "frame"};
+
+void ProfileStats::record(unsigned long elapsed)
+{
+  if (count == 0 || elapsed < minMicros) {
+    minMicros = elapsed;
+  }
+  if (elapsed > maxMicros) {
+    maxMicros = elapsed;
+  }
+  ++count;
+  totalMicros += elapsed;
+
+  uint8_t bucket = 0;
+  for (unsigned long bound = elapsed >> kProfileBucketScale; bound && bucket < PROFILE_BUCKETS - 1; bound >>= kProfileBucketScale) {
+    ++bucket;
+  }
+  if (buckets[bucket] != 0xFFFF) {
+    ++buckets[bucket];
+  }
+}
+
+unsigned long ProfileStats::percentile(uint8_t percent)
+{
+  unsigned long bucketed = 0;
+  for (uint8_t b = 0; b < PROFILE_BUCKETS; ++b) {
+    bucketed += buckets[b];
+  }
+  unsigned long above = bucketed * (100 - percent) / 100;
+  for (int b = PROFILE_BUCKETS - 1; b >= 0; --b) {
+    if (buckets[b] > above || b == 0) {
+      return min(maxMicros, (1UL << ((b + 1) * kProfileBucketScale)) - 1);
+    }
+    above -= buckets[b];
+  }
+  return maxMicros;
+}
+
+void Profiler::reset()
+{
+  memset(_stats, 0, sizeof(_stats));
+}
+
+void Profiler::poll()
+{
+  while (Serial.available() > 0) {
+    switch (Serial.read()) {
+      case 'p':
+        report();
+        break;
+      case 'r':
+        reset();
+        Serial.println("profile reset");
+        break;
+    }
+  }
+}
+
+void Profiler::report()
+{
+  char line[64];
+  Serial.println("mode stage count min mean p99 max (us) | histogram");
+  for (unsigned int slot = 0; slot < kProfiledModeCount; ++slot) {
+    const unsigned int mode = (kProfiledModeCount == 1 ? (unsigned)_mode : slot);
+    for (unsigned int stage = 0; stage < ProfileStageCount; ++stage) {
+      ProfileStats& s = _stats[slot][stage];
+      if (s.count == 0) {
+        continue;
+      }
+      snprintf(line, sizeof(line), "%u %s %lu %lu %lu %lu %lu |", mode, kProfileStageNames[stage], s.count, s.minMicros, s.totalMicros / s.count,
+               s.percentile(99), s.maxMicros);
+      Serial.print(line);
+      for (uint8_t b = 0; b < PROFILE_BUCKETS; ++b) {
+        Serial.print(' ');
+        Serial.print((unsigned int)s.buckets[b]);
+      }
+      Serial.println();
+    }
+  }
+}
+
+// Starts timing a frame in this scope
+#define PROFILE_FRAME_BEGIN() unsigned long _profileFrameStart = profileMicros(), _profileLap = _profileFrameStart
+// Ends a stage that ran since the last lap
+#define PROFILE_LAP(stage) do { unsigned long _profileNow = profileMicros(); gProfiler.record(stage, _profileNow - _profileLap); _profileLap = _profileNow; } while (0)
+#define PROFILE_FRAME_END() gProfiler.record(ProfileFrame, profileMicros() - _profileFrameStart)
+// Starts lap timing in a function called partway through the frame
+#define PROFILE_LAPS_BEGIN() unsigned long _profileLap = profileMicros()
+#define PROFILE_SET_MODE(mode) gProfiler.setMode(mode)
+#define PROFILE_POLL() gProfiler.poll()
+
+#else
+
+#define PROFILE_FRAME_BEGIN()
+#define PROFILE_LAP(stage)
+#define PROFILE_FRAME_END()
+#define PROFILE_LAPS_BEGIN()
+#define PROFILE_SET_MODE(mode)
+#define PROFILE_POLL()
+
+#endif // PROFILING
+
+#endif // PROFILER_H
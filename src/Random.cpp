@@ -0,0 +1,73 @@
+#include "Arduino.h"
+#include <FastLED.h>
+
+#include "Random.h"
+
+RandomStream gRandom;
+static uint32_t sSeed = 0;
+
+// splitmix32, to spread one seed word over the whole state
+static uint32_t splitmix32(uint32_t& state)
+{
+  uint32_t z = (state += 0x9E3779B9UL);
+  z = (z ^ (z >> 16)) * 0x85EBCA6BUL;
+  z = (z ^ (z >> 13)) * 0xC2B2AE35UL;
+  return z ^ (z >> 16);
+}
+
+void RandomStream::seed(uint32_t seed)
+{
+  _x = splitmix32(seed);
+  _y = splitmix32(seed);
+  _z = splitmix32(seed);
+  if (!(_x | _y | _z)) {
+    _x = 132456789; // all zero never leaves zero
+  }
+}
+
+void RandomStream::fill(uint8_t *out, unsigned int count)
+{
+  while (count >= 4) {
+    uint32_t r = next();
+    out[0] = r;
+    out[1] = r >> 8;
+    out[2] = r >> 16;
+    out[3] = r >> 24;
+    out += 4;
+    count -= 4;
+  }
+  if (count) {
+    uint32_t r = next();
+    while (count--) {
+      *out++ = r;
+      r >>= 8;
+    }
+  }
+}
+
+void RandomStream::fill(uint16_t *out, unsigned int count, uint16_t bound)
+{
+  while (count >= 2) {
+    uint32_t r = next();
+    out[0] = ((r & 0xFFFF) * bound) >> 16;
+    out[1] = ((r >> 16) * bound) >> 16;
+    out += 2;
+    count -= 2;
+  }
+  if (count) {
+    out[0] = ((next() & 0xFFFF) * bound) >> 16;
+  }
+}
+
+void randomSeedAll(uint32_t seed)
+{
+  sSeed = seed;
+  gRandom.seed(seed);
+  randomSeed(seed);
+  random16_set_seed(seed ^ (seed >> 16));
+}
+
+uint32_t randomSeedUsed()
+{
+  return sSeed;
+}
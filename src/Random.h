@@ -0,0 +1,62 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+// Marsaglia's xorshift96 (Xorshift RNGs, 2003), period 2^96 - 1, with its
+// state in an object so each user can have its own stream. The scene draws
+// from gRandom (which fast_rand() wraps) and each pattern from its own, so
+// what one pattern does with its numbers can't shift what the scene picks
+// next, or what the next pattern sees.
+//
+// The state is 32 bit words on every target, so a seed gives the same
+// numbers on the boards and on the host. RANDOM_SEED (Config.h) or bench -s
+// seeds everything explicitly, for runs that can be repeated.
+class RandomStream {
+public:
+  RandomStream() : _x(132456789), _y(362436069), _z(521288629) {}
+
+  // The same seed always gives the same stream
+  void seed(uint32_t seed);
+
+  uint32_t next() {
+    uint32_t t;
+
+    _x ^= _x << 16;
+    _x ^= _x >> 5;
+    _x ^= _x << 1;
+
+    t = _x;
+    _x = _y;
+    _y = _z;
+    _z = t ^ _x ^ _y;
+
+    return _z;
+  }
+
+  // [0, bound), from 16 bits like fast_rand()
+  unsigned int below(unsigned int bound) {
+    return ((next() & 0xFFFF) * (uint32_t)bound) >> 16;
+  }
+  // [minval, bound)
+  unsigned int between(unsigned int minval, unsigned int bound) {
+    return below(bound - minval) + minval;
+  }
+
+  // Bulk forms take every bit of each step: four bytes, or two 16 bit values
+  void fill(uint8_t *out, unsigned int count);
+  // Each [0, bound)
+  void fill(uint16_t *out, unsigned int count, uint16_t bound);
+
+private:
+  uint32_t _x, _y, _z;
+};
+
+extern RandomStream gRandom;
+
+// Seed gRandom and the Arduino and FastLED generators, all from one number
+void randomSeedAll(uint32_t seed);
+// The seed last given to randomSeedAll(), to log so a run can be repeated
+uint32_t randomSeedUsed();
+
+#endif // RANDOM_H
@@ -1,32 +1,17 @@
 
-#include "WS2811.h"
+#include "Output.h"
+#include "PixelMap.h"
 #include "Color.h"
 #include "ColorMaker.h"
+#include "Transitions.h"
+#include "FrameClock.h"
 #include "Config.h"
 #include "palettes.h"
-
-#if ARDUINO_TCL
-#include <TCL.h>
-#endif
-
-typedef enum {
-  ModeWaves,
-  ModeFire,
-  ModeBlueFire,
-  ModeGreenFire,
-  ModePinkFire,
-  ModeLightningBugs,
-  ModeParity,
-  ModeInterferingWaves,
-  ModeRainbow,
-  ModeAccumulator,
-  ModeCount,
-  // These are all either boring or need work.
-  
-  ModeTwinkle,
-  ModeBoomResponder,
-  ModeBounce,
-} Mode;
+#include "Pattern.h"
+#include "PatternRegistry.h"
+#include "Profiler.h"
+#include "Dither.h"
+#include "ColorCorrection.h"
 
 static const bool kLightningBugsIsEasterEgg = false;
 
@@ -53,46 +38,58 @@ static const SpeedRange kSpeedNormalRange = SpeedRangeMake(kSpeedNormalMin, kSpe
 static SpeedRange kModeRanges[ModeCount] = {0};
 #endif
 
-static const unsigned int kInterferringWavesNum = LED_COUNT / 20;
+// Patterns and their state come out of one arena, sized at boot for the
+// hungriest pattern built in
+static size_t modeArenaSize(unsigned int lightCount)
+{
+  size_t size = 0;
+  for (unsigned int i = 0; i < ARRAY_SIZE(kPatterns); ++i) {
+    size = max(size, kPatterns[i].arenaBytes(lightCount));
+  }
+  return size;
+}
+
+struct StrandStats {
+  unsigned long frames;
+  unsigned long framesSkipped; // nothing changed, so nothing was sent
+  unsigned long pixelsSkipped; // unchanged lights that weren't reprocessed
+};
 
 class Scene {
 private:
   unsigned int _lightCount=0;
   Mode _mode;
-  uint32_t _modeStart=0;
-  uint32_t _lastTick=0;
+  uint32_t _modeStart=0; // wall time
+  FrameClock _clock;
   
-  Light **_lights;
+  Lights _lights;
+  TransitionEngine _transitions;
   
-#if MEGA_WS2811
-  WS2811Renderer *ws2811Renderer;
-#elif FAST_LED
-  CRGBArray<LED_COUNT> leds;
+  OutputDriver *_output;
+  PixelMap _pixelMap;
+#if DIMMING
+  TemporalDither _dither;
 #endif
 
   float _globalSpeed; // Multiplier for global follow and fade speed
-  ColorMaker *_colorMaker = NULL;
-
-  // "Follow" convenience counter
-  float _followLeader=0;
-  int _followSpeed; // number of lights lights / s that the _followLeader moves
-  bool _directionIsReversed;
-  
-  // Mode specific data
-  unsigned int _followColorIndex=0;
-  Color *_colorScratch=NULL;
-  float *_sceneVariation = NULL;
-  unsigned int _soundPeak;
-  float *_leaders = NULL; // for interfering waves
-  unsigned long _timeMarker=0;
+  ColorMaker _colorMaker;
+  Follower _follow;
   
   PaletteRotation<CRGBPalette256> paletteRotation;
 
-  //
-  
-  void transitionAll(Color c, int durationMillis);
+  // The current mode's pattern, built in _modeArena and dropped on mode change
+  Arena _modeArena;
+  uint16_t _modeArenaHighWater[ModeCount];
+  Pattern *_pattern = NULL;
+  RandomStream _patternRandom;
+  PatternContext _context;
+
+  void endPattern();
   
-  void updateStrand();
+  // Send changed lights to the strand; force resends everything
+  void updateStrand(bool force=false);
+  int _lastBrightness = -1;
+  StrandStats _strandStats = {0, 0, 0};
 #if DEVELOPER_BOARD
   SpeedRange speedRangeForMode(Mode mode);
 #endif
@@ -100,10 +97,33 @@ private:
 public:
   void applyAll(Color c);
   void tick();
-  Scene(unsigned int ledCount);
+  // Work that can wait for the time between frames. True if there's more.
+  bool idle(unsigned long budgetMicros);
+  unsigned int framesPerSecond() {
+    return (_pattern ? _pattern->framesPerSecond() : FRAMES_PER_SECOND);
+  }
+  // Takes ownership of output; NULL uses the board's strand driver
+  Scene(unsigned int ledCount, OutputDriver *output=NULL);
   void setMode(Mode mode);
   ~Scene();
   Mode randomMode();
+  const StrandStats& strandStats() {
+    return _strandStats;
+  }
+  // False for modes this deployment doesn't build in
+  bool hasPattern(Mode mode) {
+    return patternForMode(mode) != NULL;
+  }
+  // Most mode state bytes each mode has needed so far
+  size_t modeArenaHighWater(Mode mode) {
+    if ((unsigned)mode >= ModeCount) {
+      return 0;
+    }
+    return (mode == _mode ? max((size_t)_modeArenaHighWater[mode], _modeArena.highWater()) : _modeArenaHighWater[mode]);
+  }
+  size_t modeArenaCapacity() {
+    return _modeArena.capacity();
+  }
 };
 
 uint8_t getBrightness()
@@ -113,6 +133,13 @@ uint8_t getBrightness()
   }
   static uint8_t brightnessAdjustment = 0xFF;
 #if DEVELOPER_BOARD
+  // A hand on a dial doesn't need reading every frame, and analogRead is slow
+  static const unsigned long kReadMillis = 50;
+  static unsigned long lastRead = 0UL - kReadMillis; // read on the first call
+  if (millis() - lastRead < kReadMillis) {
+    return brightnessAdjustment;
+  }
+  lastRead = millis();
   static int brightMin = 200;
   static int brightMax = 900;
   int val = analogRead(BRIGHTNESS_DIAL);
@@ -131,90 +158,79 @@ uint8_t getBrightness()
   return brightnessAdjustment;
 }
 
-Color _adjustColorForScene(Color c, uint8_t brightness)
-{
-  if (brightness != 0xFF) {
-    uint8_t dimmingFactor = dim8_raw(brightness);
-
-    c.red = scale8(c.red, dimmingFactor);
-    c.green = scale8(c.green, dimmingFactor);
-    c.blue = scale8(c.blue, dimmingFactor);
-  }
-  
-  return c;
-}
-
-void Scene::updateStrand()
+void Scene::updateStrand(bool force)
 {
+  PROFILE_LAPS_BEGIN();
   uint8_t brightnessAdjustment = getBrightness();
+  ++_strandStats.frames;
   
-  // Update per-pixel
-#if ARDUINO_TCL
-  TCL.sendEmptyFrame();
+  // Only lights that changed need reprocessing, unless the brightness moved
+  bool all = force || brightnessAdjustment != _lastBrightness;
+  if (!all && !_lights.anyDirty()) {
+    ++_strandStats.framesSkipped;
+    _strandStats.pixelsSkipped += _lightCount;
+    // Skipped frames still count, as the little they took, so the stages'
+    // stats cover every frame and not just the drawn ones
+    PROFILE_LAP(ProfileConvert);
+    PROFILE_LAP(ProfileShow);
+    return;
+  }
+  _lastBrightness = brightnessAdjustment;
+#if DIMMING
+  const bool dimmed = (brightnessAdjustment != 0xFF);
+  if (dimmed) {
+    _dither.setScale(dim8_raw(brightnessAdjustment));
+  }
 #endif
+  
+  // Update per-pixel
+  CRGB *pixels = _output->pixels();
+  unsigned int updated = 0;
+  bool anyDithering = false;
   for (unsigned int i = 0; i < _lightCount; ++i) {
-    Light *light = _lights[i];
-    int red = light->color.red, green = light->color.green, blue = light->color.blue;
-    
-    Color color = _adjustColorForScene(light->color, brightnessAdjustment);
-    Color targetColor = _adjustColorForScene(light->targetColor, brightnessAdjustment);
-    Color sourceColor = _adjustColorForScene(light->originalColor, brightnessAdjustment);
-    
-    // FIXME: comment this
-    // Nevermind, this is just a lame excuse for actual low-brightness dithering by clipping off low values if the source or target color has the same number of lit subpixels.
-    
-    if (light->isTransitioning()) {
-      unsigned int numZeroComponents = (color.red == 0 ? 1 : 0)  + (color.green == 0 ? 1 : 0) + (color.blue == 0 ? 1 : 0);
-      unsigned int targetNumZeroComponents = (targetColor.red == 0 ? 1 : 0)  + (targetColor.green == 0 ? 1 : 0) + (targetColor.blue == 0 ? 1 : 0);
-      unsigned int sourceNumZeroComponents = (sourceColor.red == 0 ? 1 : 0)  + (sourceColor.green == 0 ? 1 : 0) + (sourceColor.blue == 0 ? 1 : 0);
-      
-      if (red + green + blue < 10  && (numZeroComponents == 1 || numZeroComponents == 2) && numZeroComponents != targetNumZeroComponents && numZeroComponents != sourceNumZeroComponents) {
-        // Avoid fades like reddish-yellow -> black showing (1,0,0) == red right at the end of the fadeout
-        red = green = blue = 0;
-      }
-    } else if (red + green + blue < 5) {
-      red = green = blue = 0;
+    if (!all && !_lights.isDirty(i)) {
+      continue;
     }
-      
-#if ARDUINO_TCL
-    TCL.sendColor(red, green, blue);
-#elif MEGA_WS2811
-    // Color corrections for the WS2811 strands I use
-    red = min(1.1 * red, 255);
+    ++updated;
+    Color color = _lights.color[i];
+#if COLOR_CORRECTION
+    kColorProfiles[_pixelMap.profile(i)].apply(color);
+#endif
     
-    ws2811Renderer->setPixel(i, red, green, blue);
-#elif FAST_LED
-    leds[i] = CRGB(red, green, blue);
+    // Dithered lights stay dirty to keep alternating next frame. Their
+    // fraction has to be carried even on frames it doesn't change the output,
+    // so while dimmed nearly every lit light is reprocessed every frame, and
+    // only dark ones are skipped.
+    bool dithering = false;
+#if DIMMING
+    dithering = dimmed && _dither.apply(i, color);
 #endif
+    if (dithering) {
+      _lights.markDirty(i);
+      anyDithering = true;
+    } else {
+      _lights.clearDirty(i);
+    }
+    const uint16_t pixel = _pixelMap.map(i);
+    if (pixel != PixelMap::kUnmapped) {
+      pixels[pixel] = CRGB(color.red, color.green, color.blue);
+    }
+  }
+  _strandStats.pixelsSkipped += _lightCount - updated;
+  if (!anyDithering) {
+    _lights.clearDirty();
   }
+  PROFILE_LAP(ProfileConvert);
 
   // Send to strand
-#if ARDUINO_TCL
-  TCL.sendEmptyFrame();
-#elif MEGA_WS2811
-  ws2811Renderer->render();
-#elif FAST_LED
-#ifdef FAST_LED_PIN_2
-  // Flip strand 2 to make pattern continuous
-  CRGBArray<LED_COUNT/2> ledTemp;
-  ledTemp(LED_COUNT/2-1, 0) = leds(LED_COUNT/2, LED_COUNT-1); // mirror
-  leds(LED_COUNT/2, LED_COUNT-1) = ledTemp;
-#endif
-  FastLED.show();
-#endif
+  _output->present();
+  PROFILE_LAP(ProfileShow);
 }
 
 void Scene::applyAll(Color c)
 {
   for (unsigned int i = 0; i < _lightCount; ++i) {
-    _lights[i]->color = c;
-  }
-}
-
-void Scene::transitionAll(Color c, int durationMillis)
-{
-  for (unsigned int i = 0; i < _lightCount; ++i) {
-    _lights[i]->transitionToColor(c, durationMillis);
+    _lights.setColor(i, c);
   }
 }
 
@@ -227,7 +243,12 @@ void setSpeedRangeForMode(SpeedRange speedRange, Mode mode)
 }
 #endif
 
-Scene::Scene(unsigned int lightCount) : _mode((Mode)-1), _globalSpeed(1.0), paletteRotation(10)
+Scene::Scene(unsigned int lightCount, OutputDriver *output) : _lightCount(lightCount), _mode((Mode)-1), _lights(lightCount), _transitions(_lights),
+#if DIMMING
+  _dither(lightCount),
+#endif
+  _globalSpeed(1.0), paletteRotation(10), _modeArena(modeArenaSize(lightCount)),
+  _context{lightCount, _lights, _transitions, _clock, _colorMaker, paletteRotation, _modeArena, _follow, _modeStart, _patternRandom}
 { 
 #if DEVELOPER_BOARD
   setSpeedRangeForMode(SpeedRangeMake(0.7, 1.3), ModeFire);
@@ -238,42 +259,19 @@ Scene::Scene(unsigned int lightCount) : _mode((Mode)-1), _globalSpeed(1.0), pale
   setSpeedRangeForMode(SpeedRangeMake(kSpeedMin, kSpeedMin + 0.2), ModeLightningBugs);
 #endif
   
-  _lightCount = lightCount;
-  _lights = new Light*[_lightCount];
-  for (unsigned int i = 0; i < _lightCount; ++i) {
-    _lights[i] = new Light();
-  }
-  _lastTick = millis();
-  
-#if MEGA_WS2811
-  ws2811Renderer = new WS2811Renderer(LED_COUNT);
-#elif ARDUINO_TCL
-  // nothing
-#elif FAST_LED
-#ifdef FAST_LED_PIN_2
-  LEDS.addLeds<FASTLED_PIXEL_TYPE, FAST_LED_PIN_1, RGB>(leds, LED_COUNT/2, LED_COUNT/2);
-  LEDS.addLeds<FASTLED_PIXEL_TYPE, FAST_LED_PIN_2, RGB>(leds, LED_COUNT/2);
-#elif FAST_LED_PIN_1
-  LEDS.addLeds<FASTLED_PIXEL_TYPE, FAST_LED_PIN_1, RGB>(leds, LED_COUNT);
-#else
-  LEDS.addLeds<FASTLED_PIXEL_TYPE, RGB>(leds, LED_COUNT);
-#endif
-  // LEDS.setCorrection(0xFF9090); // edit as needed per strand deployment
-  LEDS.setBrightness(0xFF);
-#endif
+  memset(_modeArenaHighWater, 0, sizeof(_modeArenaHighWater));
+  _output = (output ? output : createOutputDriver(lightCount));
+  _pixelMap.resolve(lightCount, *_output);
    
   applyAll(kBlackColor);
-
-  _colorMaker = new ColorMaker();
 }
 
 Scene::~Scene()
 {
-  delete _colorMaker;
-#if MEGA_WS2811
-  delete ws2811Renderer;
-#endif
-  delete[] _lights;
+  if (_pattern) {
+    _pattern->~Pattern();
+  }
+  delete _output;
 }
 
 #if DEVELOPER_BOARD
@@ -293,9 +291,15 @@ SpeedRange Scene::speedRangeForMode(Mode mode)
 Mode Scene::randomMode()
 {
   int matchCount = 0;
-  Mode matchingModes[ModeCount];
-  for (int i = 0; i < ModeCount; ++i) {
-    Mode mode = (Mode)i;
+  int rotationCount = 0;
+  Mode matchingModes[ARRAY_SIZE(kPatterns)];
+  Mode rotationModes[ARRAY_SIZE(kPatterns)];
+  for (unsigned int i = 0; i < ARRAY_SIZE(kPatterns); ++i) {
+    if (!kPatterns[i].inRotation) {
+      continue;
+    }
+    Mode mode = kPatterns[i].mode;
+    rotationModes[rotationCount++] = mode;
     bool modeAllowed = true;
 
 #if MEGA_WS2811
@@ -322,121 +326,85 @@ Mode Scene::randomMode()
   }
   if (matchCount > 0) {
     return matchingModes[fast_rand(matchCount)];
+  } else if (rotationCount > 0) {
+    // No matches. Pick any mode in rotation.
+    return rotationModes[fast_rand(rotationCount)];
   } else {
-    // No matches. Pick any mode.
-    return (Mode)fast_rand(ModeCount);
+    return kPatterns[0].mode;
+  }
+}
+
+void Scene::endPattern()
+{
+  if (_pattern) {
+    _pattern->end(_context);
+    _pattern->~Pattern();
+    _pattern = NULL;
+  }
+
+  // Drop the old mode's state
+  if ((unsigned)_mode < ModeCount) {
+    _modeArenaHighWater[_mode] = max(_modeArenaHighWater[_mode], (uint16_t)_modeArena.highWater());
+    logf("  Mode %i used %u of %u arena bytes", _mode, (unsigned)_modeArena.highWater(), (unsigned)_modeArena.capacity());
   }
+  _colorMaker.reset();
+  _modeArena.reset();
 }
 
 void Scene::setMode(Mode mode)
 {
   logf("Set mode %i->%i", _mode, mode);
   if (mode != _mode) {
-    // Transition away from old mode
-    switch (_mode) {
-      case ModeLightningBugs:
-        // When ending lightning bugs, have all the bugs go out
-        transitionAll(kNightColor, 1000);
-        break;
-      default:
-        break;
-    }
-    
+    endPattern();
     _mode = mode;
-    
-    _soundPeak = 0;
-    
-    int automaticColorsCount = 0;
-    float automaticColorsDuration = 3000;
-    
-    free(_colorScratch);
-    _colorScratch = NULL;
-    
-    free(_sceneVariation);
-    _sceneVariation = NULL;
-    
-    free(_leaders);
-    _leaders = NULL;
+    PROFILE_SET_MODE(mode);
 
-    // Initialize new mode
+    // Defaults every pattern starts from
     for (unsigned int i = 0; i < _lightCount; ++i) {
-      _lights[i]->modeState = 0;
+      _lights.modeState[i] = 0;
     }
-
-    _followLeader = fast_rand(_lightCount);
-    _followSpeed = 8; // 8 lights per second by default
-    _timeMarker = 0;
-
+    _follow.leader = fast_rand(_lightCount);
+    _follow.speed = 8; // 8 lights per second by default
     paletteRotation.maxColorJump = 0xFF;
-    
-    switch (_mode) {
-      case ModeLightningBugs:
-        transitionAll(kNightColor, 1200);
-        break;
-      case ModeInterferingWaves:
-        automaticColorsCount = kInterferringWavesNum;
-        _sceneVariation = (float *)malloc(automaticColorsCount * sizeof(float));
-        _leaders = (float *)malloc(automaticColorsCount * sizeof(float));
-        for (int i = 0; i < automaticColorsCount; ++i) {
-          _sceneVariation[i] = ((int)fast_rand(0, 80) - 40) / 4.0;
-        }
-        automaticColorsDuration = 5000;
-        _colorScratch = (Color *)malloc(_lightCount * sizeof(Color));
-        break;
-      case ModeWaves: {
-        automaticColorsCount = fast_rand(2); // palettize half the time
-        logf("  Waves submode %s", automaticColorsCount == 1 ? "1 color" : "palette");
-        automaticColorsDuration = 6000;
-        
-        paletteRotation.secondsPerPalette = 20; 
-        paletteRotation.minBrightness = 20;
-
-        _sceneVariation = new float(fast_rand(3) == 0 ? 50 : 20); // wave size, assumes number of lights is roughly divisible by 50
-        break;
-      case ModeRainbow:
-        _followColorIndex = fast_rand(ROYGBIVRainbow.count);
-        break;
-      case ModeAccumulator: {
-        _colorScratch = (Color *)malloc(_lightCount * sizeof(Color));
-        _sceneVariation = new float(fast_rand(2)); // palettize sometimes
-        paletteRotation.secondsPerPalette = 20;
-        break;
-      }
-      case ModeParity: {
-        paletteRotation.secondsPerPalette = 8;
-        paletteRotation.maxColorJump = 10;
-        _followSpeed = 12;
-        break;
-      }
-      case ModeTwinkle:
-        for (unsigned i = 0; i < _lightCount; ++i) {
-          Color color = ROYGBIVRainbow.randomColor();
-          _lights[i]->transitionToColor(color, 1000);
-        }
-        break;
-      default: break;
-      }
+    _patternRandom.seed(gRandom.next());
+
+    const PatternEntry *entry = patternForMode(mode);
+    if (entry) {
+      _pattern = entry->create(_modeArena);
+    } else {
+      logf("  Mode %i isn't built in", mode);
     }
-    _colorMaker->prepColors(automaticColorsCount, automaticColorsDuration);
-    _directionIsReversed = (fast_rand(2) == 0);
-    _modeStart = millis();
+    if (_pattern) {
+      _pattern->begin(_context);
+    }
+    _follow.reversed = (fast_rand(2) == 0);
+    _modeStart = _clock.realNow();
+  }
+}
+
+bool Scene::idle(unsigned long budgetMicros)
+{
+  const unsigned long now = millis();
+  if (budgetMicros == 0) {
+    // A late frame has no time for a blend step. tick() takes it if the
+    // frames after stay late too.
+    return paletteRotation.blendDue(now);
   }
+  paletteRotation.idle(now);
+  return false;
 }
 
 void Scene::tick()
 {
-  uint32_t time = millis();
-#if DEVELOPER_BOARD
-  uint32_t tickTime = MAX(1, (time - _lastTick) * _globalSpeed);
-#else 
-  uint32_t tickTime = MAX(1, (time - _lastTick));
-#endif
-  _lastTick = time;
+  PROFILE_FRAME_BEGIN();
+  _clock.tick();
+  const uint32_t time = _clock.now();
 
   // Fade transitions
-  for (unsigned int i = 0; i < _lightCount; ++i) {
-    _lights[i]->transitionTick(tickTime);
-  }
+  _transitions.tick(_clock);
+  PROFILE_LAP(ProfileTransitions);
+  paletteRotation.tick(_clock.realNow());
+  PROFILE_LAP(ProfilePalette);
   
 #if DEVELOPER_BOARD
   static bool allOff = false;
@@ -444,13 +412,13 @@ void Scene::tick()
   if (kHasDeveloperBoard && digitalRead(TCL_SWITCH2) == LOW) {
     if (!startedOffFade) {
       for (unsigned int i = 0; i < _lightCount; ++i) {
-        _lights[i]->transitionToColor(kBlackColor, 1000, LightTransitionEaseInOut);
+        _transitions.transitionToColor(i, kBlackColor, 1000, LightTransitionEaseInOut, true);
       }
       startedOffFade = true;
     }
     if (!allOff) {
       updateStrand();
-      if (!_lights[0]->isTransitioning()) {
+      if (!_transitions.isTransitioning(0)) {
         allOff = true;
       }
     } else {
@@ -458,9 +426,9 @@ void Scene::tick()
       delay(100);
       // And set all to black periodically for any new strands that get attached, or lose and gain power.
       for (unsigned int i = 0; i < _lightCount; ++i) {
-        _lights[i]->color = kBlackColor;
+        _lights.setColor(i, kBlackColor);
       }
-      updateStrand();
+      updateStrand(true);
     }
     return;
   } else {
@@ -468,390 +436,27 @@ void Scene::tick()
     startedOffFade = false;
   }
 #endif
-  _followLeader += (_directionIsReversed ? -1 : 1) * (_followSpeed * tickTime / 1000.0);
-  _followLeader = fmodf(_followLeader + _lightCount, _lightCount);
+  _follow.leader += (_follow.reversed ? -1 : 1) * (_follow.speed * _clock.deltaMicros() / 1000000.0);
+  _follow.leader = fmodf(_follow.leader + _lightCount, _lightCount);
 
-  _colorMaker->tick();
+  _colorMaker.tick(time);
+  PROFILE_LAP(ProfileColorMaker);
   
-  switch (_mode) {
-    case ModeFire:
-    case ModeBlueFire:
-    case ModeGreenFire:
-    case ModePinkFire: {
-      // Interpolate, fade, and snap between two colors
-      Color palette[3];
-      if (_mode == ModeGreenFire) {
-        palette[0] = MakeColor(0x10, 0xFF, 0x0);
-        palette[1] = MakeColor(0xA0, 0xFF, 0x0);
-        palette[2] = MakeColor(0x0B, 0x66, 0x13);
-      } else if (_mode == ModePinkFire) {
-        palette[0] = MakeColor(0xFF, 0x0, 0xFF);
-        palette[1] = MakeColor(0xBF, 0x0, 0xFF);
-        palette[2] = MakeColor(0xF8, 0x18, 0x94);
-      } else if (_mode == ModeBlueFire) {
-        palette[0] = MakeColor(0x30, 0x10, 0xFF);
-        palette[1] = MakeColor(0, 0xB0, 0xFF);
-        palette[2] = MakeColor(0x1, 0xC0, 0xC0);
-      } else {
-        palette[0] = MakeColor(0xFF, 0x3C, 0);
-        palette[1] = MakeColor(0xFF, 0x80, 0);
-        palette[2] = MakeColor(0xDD, 0x60, 0x02);
-      }
-      for (unsigned int i = 0; i < _lightCount; ++i) {
-        Light *light = _lights[i];
-        if (!(light->isTransitioning())) {
-          long choice = fast_rand(100);
-          
-          if (choice < 10) {
-            // 10% of the time, fade slowly to black
-            light->transitionToColor(kBlackColor, 500);
-          } else {
-            // Otherwise, fade or snap to another color
-            Color new_color = palette[fast_rand(sizeof(palette)/sizeof(palette[0]))];
-            if (choice < 95) {
-              Color mixedColor = ColorWithInterpolatedColors(light->color, new_color, fast_rand(0x100), fast_rand(0x100));
-              light->transitionToColor(mixedColor, 240);
-            } else {
-              light->color = new_color;
-              // after setting the color, do a fade to this same color to keep the light "busy" for a short time.
-              light->transitionToColor(new_color, 100);
-            }
-          }
-        }
-      }
-      break;
-    }
-    
-    case ModeLightningBugs: {
-      // cycle the lightning bugs density over a minute
-      unsigned int chance = 1400 + 1000 * sin(M_PI * time / 1000 / 60);
-      for (unsigned int i = 0; i < _lightCount; ++i) {
-        Light *light = _lights[i];
-        if (!light->isTransitioning()) {
-          switch (light->modeState) {
-            case 1:
-              // When putting a bug out, fade to black first, otherwise we fade from yellow(ish) to blue and go through white.
-              light->transitionToColor(kBlackColor, 450, LightTransitionEaseInOut);
-              light->modeState = 2;
-              break;
-            case 2:
-              light->transitionToColor(kNightColor, 450);
-              light->modeState = 0;
-              break;
-            default:
-              if (fast_rand(chance) == 0) {
-                // Blinky blinky
-                light->transitionToColor(MakeColor(0xD0, 0xFF, 0), 350);
-                light->modeState = 1;
-              }
-              break;
-          }
-        }
-      }
-      break;
-    }
-    
-    case ModeBounce: {
-      static int direction = 1;
-      _lights[(int)_followLeader]->transitionToColor(kBlackColor, 400);
-      _followLeader = _followLeader + direction;
-      _lights[(int)_followLeader]->color = RGBRainbow.randomColor();
-      if (_followLeader == _lightCount - 1  || _followLeader == 0) {
-        direction = -direction;
-      }
-      break;
-    }
-    
-    case ModeWaves: {
-      const unsigned int waveLength = (float)*_sceneVariation;
-      // Needs to fade out over less than half a wave, so there are some off in the middle.
-#if DEVELOPER_BOARD
-      const int fadeDuration = 1000 * (waveLength / 2) / (_followSpeed * _globalSpeed);
-#else
-      const int fadeDuration = 1000 * (waveLength / 2) / (_followSpeed);
-#endif
-      
-      Color waveColor = kBlackColor;
-      if (_colorMaker->getColorCount() > 0) {
-        waveColor = _colorMaker->getColor(0);
-      }
-      
-      unsigned int waveCount = _lightCount / waveLength;
-      for (unsigned int i = 0; i < waveCount; ++i) {
-        if (_colorMaker->getColorCount() == 0) {
-          waveColor = Color(paletteRotation.getPaletteColor(0xFF * i / waveCount));
-        }
-        unsigned int turnOnLeaderIndex = ((int)_followLeader + i * waveLength) % _lightCount;
-        unsigned int turnOffLeaderIndex = ((int)_followLeader + i * waveLength - waveLength / 2 + _lightCount) % _lightCount;
-
-        if (!_lights[turnOnLeaderIndex]->isTransitioning()) {
-          _lights[turnOnLeaderIndex]->transitionToColor(waveColor, fadeDuration, LightTransitionEaseInOut);
-        }
-        if (!_lights[turnOffLeaderIndex]->isTransitioning()) {
-          _lights[turnOffLeaderIndex]->transitionToColor(kBlackColor, fadeDuration * 0.75, LightTransitionEaseInOut);
-        }
-      }
-      break;
-    }
-    
-    case ModeRainbow: {
-      const unsigned int waveLength = 7;
-      const int fadeDuration = 1000 * (waveLength - 2) / (_followSpeed * _globalSpeed) * 0.9;
-      
-      for (unsigned int i = 0; i < _lightCount / waveLength; ++i) {
-        unsigned int changeIndex = ((int)_followLeader + i * waveLength) % _lightCount;
-        Color waveColor = ROYGBIVRainbow.getColor(_followColorIndex + i);
-        waveColor = ColorWithInterpolatedColors(waveColor, kBlackColor, 0, 0xB0); // dim a little
-        if (!_lights[changeIndex]->isTransitioning()) {
-          _lights[changeIndex]->transitionToColor(waveColor, fadeDuration, LightTransitionEaseInOut);
-        }
-      }
-      break;
-    }
-    
-    case ModeInterferingWaves: {
-      const int waveLength = 18;
-      const int halfWave = waveLength / 2;
-      
-      // For the first 3 seconds of interfering waves, fade from previous mode
-      static const int kFadeTime = 3000;
-      unsigned long modeTime = millis() - _modeStart;
-      bool inModeTransition = modeTime < kFadeTime;
-      
-      memset(_colorScratch, 0, _lightCount * sizeof(Color));
-      float lightsChunk = _lightCount / (float)kInterferringWavesNum;
-      for (unsigned int waveIndex = 0; waveIndex < kInterferringWavesNum; ++waveIndex) {
-        if (waveIndex < kInterferringWavesNum / 2.0) { // Half the colors going in each direction
-          _leaders[waveIndex] = _followLeader + 2 * waveIndex * lightsChunk + _sceneVariation[waveIndex];
-        } else {
-          int normalizedWavedIndex = waveIndex - kInterferringWavesNum / 2.0;
-          _leaders[waveIndex] = _lightCount - (_followLeader + 2 * normalizedWavedIndex * lightsChunk + lightsChunk) + _sceneVariation[waveIndex];
-        }
-        
-        Color waveColor = _colorMaker->getColor(waveIndex);
-        
-        for (int w = -halfWave; w < halfWave; ++w) {
-          int lightIndex = (int)(_leaders[waveIndex] + w + _lightCount) % _lightCount;
-          float distance = MOD_DISTANCE(lightIndex, _leaders[waveIndex], _lightCount);
-          if (distance < halfWave) {
-            Color existingColor = _colorScratch[lightIndex];
-            
-            uint8_t litRatio = (existingColor.red + existingColor.green + existingColor.blue) / 3;
-            // If the existing light is less than about 3% lit, use the whole new color. Otherwise smoothly fade into splitting the difference.
-            const uint8_t minLit = 0xFF * 0.03;
-            const uint8_t normLit = 0xFF / 10;
-            uint8_t additionalFade = (litRatio < minLit ? 0x7F : (litRatio > normLit ? 0 : (0x7F - 0x7F * litRatio / normLit)));
-            
-//              logf("Existing color = (%i, %i, %i), litRation = %f, additionalFade = %f", existingColor.red, existingColor.green, existingColor.blue, litRatio, additionalFade);
-            
-            uint8_t fadeProgress = (1 - distance / (float)halfWave) * (0x7F + additionalFade);
-            Color color = ColorWithInterpolatedColors(existingColor, waveColor, fadeProgress, 0xFF);
-            _colorScratch[lightIndex] = color;
-            
-            color.red = ease8InOutQuad(color.red);
-            color.green = ease8InOutQuad(color.green);
-            color.blue = ease8InOutQuad(color.blue);
-
-            if (inModeTransition) {
-              // Fade from previous mode
-              color = ColorWithInterpolatedColors(_lights[lightIndex]->color, color, 0xFF * modeTime / kFadeTime, 0xFF);
-            }
-            
-            _lights[lightIndex]->color = color;
-          }
-        }
-      }
-      // Black out all other lights
-      for (unsigned int i = 0; i < _lightCount; ++i) {
-        if (ColorIsEqualToColor(_colorScratch[i], kBlackColor)) {
-          if (inModeTransition) {
-            _lights[i]->color = ColorWithInterpolatedColors(_lights[i]->color, kBlackColor, 0xFF * modeTime / kFadeTime, 0xFF);
-          } else {
-            _lights[i]->color = kBlackColor;
-          }
-        }
-      }
-      break;
-    }
-    
-    case ModeParity: {
-      paletteRotation.tick();
-      
-      const int paletteRange = min(50u, _lightCount / 2);
-      const int parityCount = 2;
-      for (int i = 0; i < (int)_lightCount; ++i) {
-        if (!_lights[i]->isTransitioning()) { // serves to not interrupt existing fades when this pattern starts
-          int parity = i % parityCount;
-          int paletteIndex = map(i + (parity ? paletteRange - _followLeader : _followLeader), 0, paletteRange, 0, 0x100);
-
-          // to avoid palette discontinuities at the endpoints, "bounce" the palette so read up to 0xFF then back down to 0, then back up.
-          paletteIndex = mod_wrap(paletteIndex, 0x200);
-          if (paletteIndex > 0xFF) {
-            paletteIndex = 0x1FF - paletteIndex;
-          }
-
-          Color targetColor = Color(paletteRotation.getPaletteColor(paletteIndex));
-
-          long modeTime = millis() - _modeStart;
-          long fadeTime = max(100, (2000 - modeTime) / 5);
-          _lights[i]->transitionToColor(targetColor, fadeTime);
-        }
-      }
-      break;
-    }
-    
-    case ModeBoomResponder:
-      for (unsigned int i = 0; i < _lightCount; ++i) {
-        if (!_lights[i]->isTransitioning()) {
-          _lights[i]->transitionToColor(NamedRainbow.randomColor(), 1000);
-        }
-      }
-      break;
-    
-    case ModeAccumulator: {
-      const int kernelWidth = 1;
-      
-      paletteRotation.tick();
-      
-  #if DEVELOPER_BOARD
-      const unsigned int kPingInterval = 30000 / _lightCount / _globalSpeed;
-      const unsigned int kBlurInterval = 50 / _globalSpeed;
-  #else
-      const unsigned int kPingInterval = 30000 / _lightCount;
-      const unsigned int kBlurInterval = 50;
-  #endif
-      if (time - _timeMarker > kPingInterval) {
-        unsigned int ping = fast_rand(_lightCount);
-        Color c = kBlackColor;
-        if (_sceneVariation && *_sceneVariation) {
-          c = Color(paletteRotation.getPaletteColor(random8()));
-        } else {
-          c = NamedRainbow.randomColor();
-        }
-
-        for (unsigned int i = (ping - 1); i <= ping + 1; ++i) {
-          unsigned int light = (i + _lightCount) % _lightCount;
-          _lights[light]->transitionToColor(c, 250, LightTransitionEaseInOut);
-        }
-        
-        _timeMarker = time;
-      }
-      
-      static unsigned long lastBlur = 0;
-      
-      for (unsigned int i = 0; i < _lightCount; ++i) {
-        Color c = _lights[i]->color;
-        _colorScratch[i] = c;
-      }
-      
-      if (time - lastBlur > kBlurInterval) {  
-        for (unsigned int target = 0; target < _lightCount; ++target) {
-          if (_lights[target]->isTransitioning()) {
-            continue;
-          }
-          Color c = kBlackColor;
-          unsigned int count = 0;
-          
-          float multiplier = 1.0;
-          
-          for (int k = -kernelWidth; k <= kernelWidth; ++k) {
-            unsigned int source = (target + k + _lightCount) % _lightCount;
-            Color sourceColor = _colorScratch[source];
-            
-            if (sourceColor.red + sourceColor.green + sourceColor.blue < 20) {
-              continue;
-            } else {
-              c.red = (c.red * count + sourceColor.red) / (float)(count + 1);
-              c.green = (c.green * count + sourceColor.green) / (float)(count + 1);
-              c.blue = (c.blue * count + sourceColor.blue) / (float)(count + 1);
-              ++count;
-            }
-          }
-
-          c.red *= 0.92 * multiplier;
-          c.green *= 0.92 * multiplier;
-          c.blue *= 0.92 * multiplier;
-          
-          _lights[target]->transitionToColor(c, 200);
-        }
-        lastBlur = time;
-      }
-      break;
-    }
-    case ModeTwinkle: {
-      static Color TwinkleRainbow[] = {kRedColor, kOrangeColor, kYellowColor, kGreenColor, kCyanColor, kBlueColor, kMagentaColor, kVioletColor, kBlackColor, kBlackColor};
-      bool anyTransitionHappening = false;
-      for (unsigned i = 0; i < _lightCount; ++i) {
-        if (_lights[i]->isTransitioning()) {
-          anyTransitionHappening = true;
-          break;
-        }
-      }
-      if (!anyTransitionHappening) {
-        static int parity = 5;
-        static int lastSegmentChanged = -1;
-        for (int twice = 0; twice < 2; ++twice) {
-          int changeSegment;
-          do {
-            changeSegment = fast_rand(parity);
-          } while (changeSegment == lastSegmentChanged);
-          lastSegmentChanged = changeSegment;
-          
-          Color startColor = _lights[changeSegment]->color;
-          Color targetColor;
-          
-          // Black is a possible target, so make sure we don't transition to a completely black strand
-          bool acceptableColor = false;
-          do {
-            targetColor = TwinkleRainbow[fast_rand(ARRAY_SIZE(TwinkleRainbow))];
-            
-            if (ColorIsEqualToColor(startColor, targetColor)) {
-              // Actually change the color
-              continue;
-            }
-            if (ColorTransitionWillProduceWhite(startColor, targetColor)) {
-              // Don't fade through white
-              continue;
-            }
-            
-            bool targetIsBlackColor = ColorIsEqualToColor(targetColor, kBlackColor);
-            if (targetIsBlackColor) {
-              bool transitioningToAllBlack = true;
-              for (int seg = 0; seg < parity; ++seg) {
-                Color segColor = (_lights[seg]->isTransitioning() ? _lights[seg]->targetColor : _lights[seg]->color);
-                if (seg != changeSegment && !ColorIsEqualToColor(segColor, kBlackColor)) {
-                  transitioningToAllBlack = false;
-                  break;
-                }
-              }
-              if (transitioningToAllBlack) {
-                // who turned out the lights?
-                continue;
-              }
-            }
-            acceptableColor = true;
-          } while (!acceptableColor);
-          
-          for (unsigned i = changeSegment; i < _lightCount; i += parity) {
-            _lights[i]->transitionToColor(targetColor, 1000);
-          }
-        }
-      }
-      break;
-    }
-    
-    default: // Turn all off
-      applyAll(kBlackColor);
-      break;
+  if (_pattern) {
+    _pattern->tick(_context);
+  } else {
+    // Turn all off
+    applyAll(kBlackColor);
   }
+  PROFILE_LAP(ProfileMode);
   
   updateStrand();
   
 #ifndef TEST_MODE
-  if (time - _modeStart > (uint32_t)MODE_TIME * 1000) {
+  if (_clock.realNow() - _modeStart > (uint32_t)MODE_TIME * 1000) {
     Mode nextMode = randomMode();
     logf("Timed mode change to %i", (int)nextMode);
-    _modeStart = time; // in case mode doesn't actually change here.
+    _modeStart = _clock.realNow(); // in case mode doesn't actually change here.
     setMode(nextMode);
   } else {
 #endif
@@ -862,6 +467,7 @@ void Scene::tick()
     if (abs(newGlobalSpeed - _globalSpeed) > 0.06) {
       logf("New global speed = %f", newGlobalSpeed);
       _globalSpeed = newGlobalSpeed;
+      _clock.speed = _globalSpeed;
 #ifndef TEST_MODE
       // Switch out of modes that are too slow or fast for the new global speed
       SpeedRange range = speedRangeForMode(_mode);
@@ -882,11 +488,21 @@ void Scene::tick()
   static bool button1Down = true;
   if (kHasDeveloperBoard && digitalRead(TCL_MOMENTARY1) == LOW) {
     if (!button1Down) {
-      setMode((Mode)((_mode + 1) % ModeCount));
+      // Step through the modes in rotation
+      const PatternEntry *current = patternForMode(_mode);
+      unsigned int next = (current ? current - kPatterns : ARRAY_SIZE(kPatterns) - 1);
+      for (unsigned int step = 0; step < ARRAY_SIZE(kPatterns); ++step) {
+        next = (next + 1) % ARRAY_SIZE(kPatterns);
+        if (kPatterns[next].inRotation) {
+          break;
+        }
+      }
+      setMode(kPatterns[next].mode);
       button1Down = true;
     }
   } else {
     button1Down = false;
   }
 #endif
+  PROFILE_FRAME_END();
 }
@@ -0,0 +1,258 @@
+#ifndef TRANSITIONS_H
+#define TRANSITIONS_H
+
+#include "Color.h"
+#include "Light.h"
+#include "FrameClock.h"
+
+// Owns every in-flight fade and advances them all in one pass per frame.
+//
+// Fades are kept per light in parallel arrays, plus a dense list of the lights
+// that are fading so tick() only touches those. Progress is accumulated from
+// the frame delta and scaled by a per-fade rate computed once when the fade is
+// submitted, so the per-frame kernel has no divides and no timer reads. A fade
+// is over once its progress reaches full, so the rate is all that's kept of
+// its duration.
+//
+// Fades run on the frame clock's animation time, so they follow the global
+// speed, unless submitted with ignoresSpeed (lightning bugs, the power switch).
+
+class TransitionEngine {
+public:
+  TransitionEngine(Lights& lights);
+  ~TransitionEngine();
+
+  Color *targetColor;
+  Color *originalColor;
+
+  void transitionToColor(unsigned int index, Color transitionTargetColor, int durationMillis, LightTransitionCurve curve, bool ignoresSpeed);
+  void transitionToColor(unsigned int index, Color transitionTargetColor, int durationMillis, LightTransitionCurve curve);
+  void transitionToColor(unsigned int index, Color transitionTargetColor, int durationMillis);
+  void stopTransition(unsigned int index);
+  bool isTransitioning(unsigned int index) {
+    return (flags[index] & kFading);
+  }
+  unsigned int activeCount() {
+    return _activeCount;
+  }
+  // Lights whose fade ended, or was stopped, in the last tick(). Lets a mode
+  // find the lights that just went idle without checking every light:
+  //   for (i = nextFinished(0); i < count; i = nextFinished(i + 1))
+  bool isFinished(unsigned int index) {
+    return _finished[index >> 3] & (1 << (index & 7));
+  }
+  // The first finished light from index on, or the light count if there's none
+  unsigned int nextFinished(unsigned int index);
+  unsigned int finishedCount() {
+    return _finishedCount;
+  }
+  // Ticks so far. A mode whose tick didn't run after every one of them (the
+  // scene skips it while the power switch is off) missed some finished lights,
+  // and has to look over every light instead.
+  unsigned long tickCount() {
+    return _tickCount;
+  }
+
+  // Advance all fades by one frame
+  void tick(const FrameClock& clock);
+
+  void printDescription(unsigned int index);
+
+private:
+  enum {
+    kCurveMask = 0x0F,
+    kIgnoresSpeed = 0x20,
+    kFading = 0x40,
+    kListed = 0x80, // present in the active list, possibly already stopped
+  };
+
+  Lights& _lights;
+
+  uint32_t *rate; // progress per milli, 8.16 fixed point, rounded up
+  uint16_t *elapsed; // in millis
+  uint16_t *active;
+  uint8_t *flags;
+  uint8_t *_finished; // one bit per light
+  unsigned int _activeCount = 0;
+  unsigned int _finishedCount = 0;
+  unsigned long _tickCount = 0;
+
+  void *storage;
+};
+
+// ease8InOutQuad, tabulated. Indexed by curve - 1; linear needs no table.
+static const uint8_t kTransitionCurveTables[][256] PROGMEM = {
+  { // LightTransitionEaseInOut
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x04, 0x04, 0x04, 0x04, 0x04, 0x06, 0x06, 0x06, 0x06,
+    0x08, 0x08, 0x08, 0x08, 0x0A, 0x0A, 0x0A, 0x0C, 0x0C, 0x0C, 0x0E, 0x0E, 0x0E, 0x10, 0x10, 0x10,
+    0x12, 0x12, 0x12, 0x14, 0x14, 0x16, 0x16, 0x18, 0x18, 0x18, 0x1A, 0x1A, 0x1C, 0x1C, 0x1E, 0x1E,
+    0x20, 0x20, 0x22, 0x22, 0x24, 0x24, 0x26, 0x26, 0x28, 0x2A, 0x2A, 0x2C, 0x2C, 0x2E, 0x30, 0x30,
+    0x32, 0x32, 0x34, 0x36, 0x36, 0x38, 0x3A, 0x3A, 0x3C, 0x3E, 0x3E, 0x40, 0x42, 0x44, 0x44, 0x46,
+    0x48, 0x4A, 0x4A, 0x4C, 0x4E, 0x50, 0x52, 0x52, 0x54, 0x56, 0x58, 0x5A, 0x5A, 0x5C, 0x5E, 0x60,
+    0x62, 0x64, 0x66, 0x68, 0x6A, 0x6A, 0x6C, 0x6E, 0x70, 0x72, 0x74, 0x76, 0x78, 0x7A, 0x7C, 0x7E,
+    0x81, 0x83, 0x85, 0x87, 0x89, 0x8B, 0x8D, 0x8F, 0x91, 0x93, 0x95, 0x95, 0x97, 0x99, 0x9B, 0x9D,
+    0x9F, 0xA1, 0xA3, 0xA5, 0xA5, 0xA7, 0xA9, 0xAB, 0xAD, 0xAD, 0xAF, 0xB1, 0xB3, 0xB5, 0xB5, 0xB7,
+    0xB9, 0xBB, 0xBB, 0xBD, 0xBF, 0xC1, 0xC1, 0xC3, 0xC5, 0xC5, 0xC7, 0xC9, 0xC9, 0xCB, 0xCD, 0xCD,
+    0xCF, 0xCF, 0xD1, 0xD3, 0xD3, 0xD5, 0xD5, 0xD7, 0xD9, 0xD9, 0xDB, 0xDB, 0xDD, 0xDD, 0xDF, 0xDF,
+    0xE1, 0xE1, 0xE3, 0xE3, 0xE5, 0xE5, 0xE7, 0xE7, 0xE7, 0xE9, 0xE9, 0xEB, 0xEB, 0xED, 0xED, 0xED,
+    0xEF, 0xEF, 0xEF, 0xF1, 0xF1, 0xF1, 0xF3, 0xF3, 0xF3, 0xF5, 0xF5, 0xF5, 0xF7, 0xF7, 0xF7, 0xF7,
+    0xF9, 0xF9, 0xF9, 0xF9, 0xFB, 0xFB, 0xFB, 0xFB, 0xFB, 0xFD, 0xFD, 0xFD, 0xFD, 0xFD, 0xFD, 0xFD,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  },
+};
+
+TransitionEngine::TransitionEngine(Lights& lights) : _lights(lights)
+{
+  const unsigned int count = lights.count;
+  // One block for every channel, widest fields first so each array stays aligned
+  const size_t finishedBytes = (count + 7) / 8;
+  size_t perLight = sizeof(uint32_t) + 2 * sizeof(uint16_t) + 2 * sizeof(Color) + sizeof(uint8_t);
+  storage = malloc(count * perLight + finishedBytes);
+  memset(storage, 0, count * perLight + finishedBytes);
+
+  uint8_t *p = (uint8_t *)storage;
+  rate = (uint32_t *)p;
+  p += count * sizeof(uint32_t);
+  elapsed = (uint16_t *)p;
+  p += count * sizeof(uint16_t);
+  active = (uint16_t *)p;
+  p += count * sizeof(uint16_t);
+  targetColor = (Color *)p;
+  p += count * sizeof(Color);
+  originalColor = (Color *)p;
+  p += count * sizeof(Color);
+  flags = p;
+  p += count * sizeof(uint8_t);
+  _finished = p;
+}
+
+TransitionEngine::~TransitionEngine()
+{
+  free(storage);
+}
+
+void TransitionEngine::transitionToColor(unsigned int index, Color transitionTargetColor, int durationMillis, LightTransitionCurve curve, bool ignoresSpeed)
+{
+  if (durationMillis <= 0) {
+    durationMillis = 1;
+  } else if (durationMillis > 0xFFFF) {
+    durationMillis = 0xFFFF;
+  }
+  targetColor[index] = transitionTargetColor;
+  originalColor[index] = _lights.color[index];
+  // Rounded up, so the fade never runs past its duration
+  rate[index] = (0xFF0000UL + durationMillis - 1) / (uint16_t)durationMillis;
+  elapsed[index] = 0;
+  if (!(flags[index] & kListed)) {
+    active[_activeCount++] = index;
+  }
+  flags[index] = kListed | kFading | (ignoresSpeed ? kIgnoresSpeed : 0) | (curve & kCurveMask);
+}
+
+void TransitionEngine::transitionToColor(unsigned int index, Color transitionTargetColor, int durationMillis, LightTransitionCurve curve)
+{
+  transitionToColor(index, transitionTargetColor, durationMillis, curve, false);
+}
+
+void TransitionEngine::transitionToColor(unsigned int index, Color transitionTargetColor, int durationMillis)
+{
+  transitionToColor(index, transitionTargetColor, durationMillis, LightTransitionLinear, false);
+}
+
+void TransitionEngine::stopTransition(unsigned int index)
+{
+  // Stays in the active list until the next tick drops it
+  flags[index] &= ~kFading;
+  _lights.markDirty(index);
+}
+
+unsigned int TransitionEngine::nextFinished(unsigned int index)
+{
+  const unsigned int count = _lights.count;
+  if (_finishedCount == 0) {
+    return count;
+  }
+  while (index < count) {
+    uint8_t bits = _finished[index >> 3] >> (index & 7);
+    if (!bits) {
+      index = (index | 7) + 1; // the rest of this byte is idle
+      continue;
+    }
+    while (!(bits & 1)) {
+      bits >>= 1;
+      ++index;
+    }
+    return index;
+  }
+  return count;
+}
+
+void TransitionEngine::tick(const FrameClock& clock)
+{
+  // Progress before a tick is under 0xFF0000 and the rate at most that, so a
+  // delta of at most 0xFF can't overflow the 32 bit product. Frames are far
+  // shorter; a stall longer than that just slows its fades.
+  const uint16_t delta = min(clock.delta(), 0xFFUL);
+  const uint16_t realDelta = min(clock.realDelta(), 0xFFUL);
+
+  Color *color = _lights.color;
+  unsigned int kept = 0;
+  if (_finishedCount > 0) {
+    memset(_finished, 0, (_lights.count + 7) / 8);
+    _finishedCount = 0;
+  }
+  ++_tickCount;
+  for (unsigned int a = 0; a < _activeCount; ++a) {
+    const uint16_t i = active[a];
+    const uint8_t f = flags[i];
+    if (!(f & kFading)) {
+      flags[i] = 0;
+      _finished[i >> 3] |= (1 << (i & 7));
+      ++_finishedCount;
+      continue;
+    }
+
+    const uint32_t e = (uint32_t)elapsed[i] + (f & kIgnoresSpeed ? realDelta : delta);
+    const uint32_t fixedProgress = e * rate[i];
+    if (fixedProgress >= 0xFF0000UL) {
+      color[i] = targetColor[i];
+      flags[i] = 0;
+      _lights.markDirty(i);
+      _finished[i >> 3] |= (1 << (i & 7));
+      ++_finishedCount;
+      continue;
+    }
+    elapsed[i] = e;
+
+    uint8_t progress = fixedProgress >> 16;
+    const uint8_t curve = f & kCurveMask;
+    if (curve != LightTransitionLinear) {
+      progress = pgm_read_byte(&kTransitionCurveTables[curve - 1][progress]);
+    }
+
+    const Color& originalColor = this->originalColor[i];
+    const Color& targetColor = this->targetColor[i];
+    Color c;
+    c.red = lerp8by8(originalColor.red, targetColor.red, progress);
+    c.green = lerp8by8(originalColor.green, targetColor.green, progress);
+    c.blue = lerp8by8(originalColor.blue, targetColor.blue, progress);
+    _lights.setColor(i, c);
+
+    active[kept++] = i;
+  }
+  _activeCount = kept;
+}
+
+void TransitionEngine::printDescription(unsigned int index)
+{
+  char buf[20];
+  snprintf(buf, 20, "%u", index);
+  Serial.print("<Light ");
+  Serial.print(buf);
+  Serial.print(" isTransitioning = ");
+  Serial.print(isTransitioning(index) ? "yes" : "no");
+  Serial.print(">");
+}
+
+#endif // TRANSITIONS_H
@@ -1,12 +1,8 @@
-#include "stdarg.h"
-
 #include "Arduino.h"
 #include "Config.h"
 #include "Color.h"
 #include "Utilities.h"
 
-void logf(const char *format, ...);
-
 float PotentiometerReadf(int pin, float rangeMin, float rangeMax)
 {
   // Potentiometer has range [0, 1023]
@@ -19,20 +15,9 @@ long PotentiometerRead(int pin, int rangeMin, int rangeMax)
   return round(analogRead(pin) / 1023.0 * (rangeMax - rangeMin) + rangeMin);
 }
 
-/* Begin Mozzi Random */
-
-// moved these out of xorshift96() so xorshift96() can be reseeded manually
-static unsigned long x = 132456789, y = 362436069, z = 521288629;
+/* Random */
 
-/** @ingroup random
-Random number generator. A faster replacement for Arduino's random function,
-which is too slow to use with Mozzi.  
-Based on Marsaglia, George. (2003). Xorshift RNGs. http://www.jstatsoft.org/v08/i14/xorshift.pdf
-@return a random 32 bit integer.
-@todo check timing of xorshift96(), rand() and other PRNG candidates.
- */
-
- int lsb_noise(int pin, int numbits) {
+int lsb_noise(int pin, int numbits) {
   // TODO: Use Entropy.h? Probs not needed just to randomize pattern.
   int noise = 0;
   for (int i = 0; i < numbits; ++i) {
@@ -42,43 +27,16 @@ Based on Marsaglia, George. (2003). Xorshift RNGs. http://www.jstatsoft.org/v08/
   return noise;
 }
 
-void fast_srand()
-{
-  x += lsb_noise(A0, 8 * sizeof(unsigned long));
-  y += lsb_noise(A1, 8 * sizeof(unsigned long));
-  z += lsb_noise(A2, 8 * sizeof(unsigned long));
-}
-
-unsigned long xorshift96()
-{ //period 2^96-1
-    // static unsigned long x=123456789, y=362436069, z=521288629;
-    unsigned long t;
-
-    x ^= x << 16;
-    x ^= x >> 5;
-    x ^= x << 1;
-
-    t = x;
-    x = y;
-    y = z;
-    z = t ^ x ^ y;
-
-    return z;
-}
-
 unsigned int fast_rand(unsigned int minval, unsigned int upperBound)
 {
-  unsigned int val = (unsigned int) ((((xorshift96() & 0xFFFF) * (upperBound-minval))>>16) + minval);
-  return val;
+  return gRandom.between(minval, upperBound);
 }
 
 unsigned int fast_rand(unsigned int upperBound)
 {
-  unsigned int val = (unsigned int) (((xorshift96() & 0xFFFF) * (upperBound))>>16);
-  return val;
+  return gRandom.below(upperBound);
 }
 
-/* End Mozzi Random */
 
 extern int __bss_end;
 extern void *__brkval;
@@ -116,47 +74,6 @@ std::string colorDesc(CRGB c) {
 }
 #endif
 
-#if !MEGA
-static int vasprintf(char** strp, const char* fmt, va_list ap) {
-  va_list ap2;
-  va_copy(ap2, ap);
-  char tmp[1];
-  int size = vsnprintf(tmp, 1, fmt, ap2);
-  if (size <= 0) {
-    Serial.println("vsnprintf fail");
-    strp=NULL;
-    return size;
-  }
-  va_end(ap2);
-  size += 1;
-  *strp = (char*)malloc(size * sizeof(char));
-  return vsnprintf(*strp, size, fmt, ap);
-}
-#endif
-
-void logf(const char *format, ...)
-{
-#if !MEGA // this eventually yields memory errors on mega, not sure why
-  va_list argptr;
-  va_start(argptr, format);
-  char *buf;
-  vasprintf(&buf, format, argptr);
-  va_end(argptr);
-  Serial.println(buf ? buf : "LOGF MEMORY ERROR");
-  free(buf);
-#else
-  va_list argptr;
-  va_start(argptr, format);
-  char buf[127];
-  vsnprintf(buf, 127, format, argptr);
-  va_end(argptr);
-  Serial.println(buf);
-#endif
-#if DEBUG
-  Serial.flush();
-#endif
-}
-
 int mod_wrap(int x, int m) {
   int result = x % m;
   return result < 0 ? result + m : result;
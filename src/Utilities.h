@@ -2,21 +2,20 @@
 #include <string>
 #endif
 #include <FastLED.h>
+#include "Log.h"
+#include "Random.h"
 
 #if DEBUG
-#define assert(expr, reason) if (!(expr)) { logf("ASSERTION FAILED: %s", reason); while (1) delay(100); }
+#define assert(expr, reason) if (!(expr)) { logf("ASSERTION FAILED: %s", reason); logFlush(); while (1) delay(100); }
 #else
 #define assert(expr, reason) if (!(expr)) { logf("ASSERTION FAILED"); }
 #endif
 
 struct Color;
 
-void logf(const char *format, ...);
-
 float PotentiometerReadf(int pin, float rangeMin, float rangeMax);
 long PotentiometerRead(int pin, int rangeMin, int rangeMax);
 
-void fast_srand();
 int lsb_noise(int pin, int numbits);
 unsigned int fast_rand(unsigned int minval, unsigned int maxval);
 unsigned int fast_rand(unsigned int maxval);
@@ -29,15 +28,12 @@ void PrintColor(Color c);
 std::string colorDesc(CRGB c);
 #endif
 
-void logf(const char *format, ...);
-
 int mod_wrap(int x, int m);
 
 class FrameCounter {
   private:
     long lastPrint = 0;
     long frames = 0;
-    long lastClamp = 0;
   public:
     long printInterval = 2000;
     void tick() {
@@ -57,11 +53,4 @@ class FrameCounter {
       }
       ++frames;
     }
-    void clampToFramerate(int fps) {
-      int delayms = 1000 / fps - (millis() - lastClamp);
-      if (delayms > 0) {
-        delay(delayms);
-      }
-      lastClamp = millis();
-    }
 };
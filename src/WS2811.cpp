@@ -5,11 +5,16 @@
 
 #if MEGA_WS2811
 
-WS2811Renderer::WS2811Renderer(unsigned int numPixels)
+WS2811Renderer::WS2811Renderer(unsigned int numPixels, uint8_t *buffer)
 {
   this->numPixels = numPixels;
-  pixelBuffer = (uint8_t *)malloc(numPixels * 3);
-  memset(pixelBuffer, 0, numPixels * 3);
+  ownsBuffer = (buffer == NULL);
+  if (ownsBuffer) {
+    pixelBuffer = (uint8_t *)malloc(numPixels * 3);
+    memset(pixelBuffer, 0, numPixels * 3);
+  } else {
+    pixelBuffer = buffer;
+  }
   
   pinMode(DIGITAL_PIN,OUTPUT);
   digitalWrite(DIGITAL_PIN,0);
@@ -17,7 +22,9 @@ WS2811Renderer::WS2811Renderer(unsigned int numPixels)
 
 WS2811Renderer::~WS2811Renderer()
 {
-  free(pixelBuffer);
+  if (ownsBuffer) {
+    free(pixelBuffer);
+  }
 }
 
 void WS2811Renderer::setPixel(unsigned int index, byte red, byte green, byte blue)
@@ -13,9 +13,11 @@
 class WS2811Renderer {
 private:
   uint8_t* pixelBuffer = NULL;
+  bool ownsBuffer;
   unsigned int numPixels;
 public:
-  WS2811Renderer(unsigned int numPixels);
+  // Renders from `buffer` (3 bytes per pixel, RGB) if given, else allocates one
+  WS2811Renderer(unsigned int numPixels, uint8_t *buffer = NULL);
   ~WS2811Renderer();
   void setPixel(unsigned int index, byte red, byte green, byte blue);
   void render();
@@ -14,9 +14,6 @@
 // -----------------------------------------
 //
 // TODOs!: 
-// * Don't use enum count for picking from the mode list. Just put all the modes in the enum, and list them out for each deployment kind so I can toggle.
-// * Refactor cruft in Scene.h so patterns are actually modularized, just subclass so they can store their own mode vars
-// * Factor our light transitions from Light.h and put them in an animation class that can handle multiple lights at a time. Goal: Interferring waves should not have to crossfade
 // * Get rid of "Twinkle." It sucks. Replace it with something good.
 // * Pattern with several follow leads traveling around in various directions and auto colors, colors are blended additively.
 // * 
@@ -31,6 +28,7 @@
 #include "Color.h"
 #include "Light.h"
 #include "Scene.h"
+#include "FrameScheduler.h"
 #include "WS2811.h"
 
 #if ARDUINO_TCL
@@ -46,6 +44,12 @@
 #endif
 
 static Scene *gLights;
+static FrameScheduler gScheduler(FRAMES_PER_SECOND);
+
+static bool sceneIdle(unsigned long budgetMicros)
+{
+  return gLights->idle(budgetMicros);
+}
 
 #if WAIT_FOR_SERIAL
 static bool serialTimeout = false;
@@ -102,11 +106,16 @@ void setup() {
 #endif
 #endif
   
-  fast_srand();
-  randomSeed(lsb_noise(UNCONNECTED_PIN_1, 8 * sizeof(uint32_t)));
-  random16_add_entropy(lsb_noise(UNCONNECTED_PIN_2, 8 * sizeof(uint16_t)));
+#if RANDOM_SEED
+  randomSeedAll(RANDOM_SEED);
+#else
+  randomSeedAll((uint32_t)lsb_noise(UNCONNECTED_PIN_1, 16) << 16 | (uint16_t)lsb_noise(UNCONNECTED_PIN_2, 16));
+#endif
+  logf("Random seed %lu", (unsigned long)randomSeedUsed());
   
   gLights = new Scene(LED_COUNT);
+  gScheduler.addIdleHook(logDrain);
+  gScheduler.addIdleHook(sceneIdle);
 #ifdef TEST_MODE
   gLights->setMode(TEST_MODE);
 #else
@@ -119,7 +128,6 @@ FrameCounter fc;
 void loop()
 {
   fc.tick();
-  fc.clampToFramerate(120);
   
 #if DEBUG && MEGA
 unsigned long mils = millis();
@@ -133,4 +141,8 @@ unsigned long mils = millis();
 #endif
 
   gLights->tick();
+  PROFILE_POLL();
+
+  gScheduler.setFramesPerSecond(gLights->framesPerSecond());
+  gScheduler.waitForNextFrame();
 }
@@ -1,3 +1,6 @@
+#ifndef PALETTES_H
+#define PALETTES_H
+
 
 #include <FastLED.h>
 
@@ -582,34 +585,68 @@ static int linearBrightness(CRGB color) {
   return (color.r + color.g + color.b);
 }
 
+// Picks random gradients that meet brightness and smoothness constraints.
+//
+// Each gradient is expanded and measured once, the first time a palette is
+// asked for, and the list of gradients meeting the last constraints asked for
+// is kept, so a pick is a single random draw.
 template <class T>
 class PaletteManager {
 private:
-  bool paletteHasColorBelowThreshold(T& palette, uint8_t minBrightness) {
-    if (minBrightness == 0) {
-      return false;
-    }
-    for (uint16_t i = 0; i < sizeof(T)/3; ++i) {
-      if (linearBrightness(palette.entries[i]) < minBrightness) {
-        return true;
+  struct PaletteTraits {
+    uint8_t minBrightness; // dimmest entry's linear brightness, capped at 0xFF
+    uint8_t maxJump; // largest change between neighbouring entries
+    uint8_t wrappedJump; // same, including last entry back to the first
+  };
+
+  PaletteTraits traits[gGradientPaletteCount];
+  bool hasTraits = false;
+
+  uint8_t eligible[gGradientPaletteCount];
+  uint8_t eligibleCount = 0;
+  uint8_t eligibleMinBrightness = 0;
+  uint8_t eligibleMaxColorJump = 0;
+  bool eligibleWrapped = false;
+  bool hasEligible = false;
+
+  static uint8_t colorJump(CRGB c1, CRGB c2) {
+    return (abs((int)c1.r - (int)c2.r) + abs((int)c1.g - (int)c2.g) + abs((int)c1.b - (int)c2.b)) / 3;
+  }
+
+  // `scratch` is overwritten while each gradient gets measured
+  void measurePalettes(T* scratch) {
+    const uint16_t entryCount = sizeof(T) / 3;
+    for (uint8_t p = 0; p < gGradientPaletteCount; ++p) {
+      *scratch = gGradientPalettes[p];
+      int minBrightness = 0xFF;
+      uint8_t maxJump = 0;
+      for (uint16_t i = 0; i < entryCount; ++i) {
+        minBrightness = min(minBrightness, linearBrightness(scratch->entries[i]));
+        if (i > 0) {
+          maxJump = max(maxJump, colorJump(scratch->entries[i - 1], scratch->entries[i]));
+        }
       }
+      traits[p].minBrightness = minBrightness;
+      traits[p].maxJump = maxJump;
+      traits[p].wrappedJump = max(maxJump, colorJump(scratch->entries[entryCount - 1], scratch->entries[0]));
     }
-    return false;
+    hasTraits = true;
   }
 
-  uint8_t paletteColorJump(T& palette, bool wrapped=false) {
-    uint8_t maxJump = 0;
-    CRGB lastColor = palette.entries[(wrapped ? sizeof(T)/3 - 1 : 1)];
-    for (uint16_t i = (wrapped ? 0 : 1); i < sizeof(T)/3; ++i) {
-      CRGB color = palette.entries[i];
-      uint8_t distance = (abs((int)color.r - (int)lastColor.r) + abs((int)color.g - (int)lastColor.g) + abs((int)color.b - (int)lastColor.b)) / 3;
-      if (distance > maxJump) {
-        maxJump = distance;
+  void findEligible(uint8_t minBrightness, uint8_t maxColorJump, bool wrapped) {
+    eligibleCount = 0;
+    for (uint8_t p = 0; p < gGradientPaletteCount; ++p) {
+      const PaletteTraits& t = traits[p];
+      if (t.minBrightness >= minBrightness && (wrapped ? t.wrappedJump : t.maxJump) <= maxColorJump) {
+        eligible[eligibleCount++] = p;
       }
-      lastColor = color;
     }
-    return maxJump;
+    eligibleMinBrightness = minBrightness;
+    eligibleMaxColorJump = maxColorJump;
+    eligibleWrapped = wrapped;
+    hasEligible = true;
   }
+
 public:  
   PaletteManager() {
   }
@@ -619,22 +656,18 @@ public:
   }
   
   // Memory note: Never pass around copies of T in the stack because CRGBPalette256 is too memory-heavy to copy on mega
-  void getRandomPalette(T* palettePtr, uint8_t minBrightness=0, uint8_t maxColorJump=0xFF) {
-    unsigned firstChoice = random16(gGradientPaletteCount);
-    unsigned choice = firstChoice;
-    *palettePtr = gGradientPalettes[choice];    
-    bool belowMinBrightness = paletteHasColorBelowThreshold(*palettePtr, minBrightness);
-    uint8_t colorJump = paletteColorJump(*palettePtr);
-    int tries = 0;
-    while (belowMinBrightness || colorJump > maxColorJump) {
-      choice = addmod8(choice, 1, gGradientPaletteCount);
-      assert(choice != firstChoice, "No palettes of acceptable brightness & color continuity");
-      *palettePtr = gGradientPalettes[choice];
-      belowMinBrightness = paletteHasColorBelowThreshold(*palettePtr, minBrightness);
-      colorJump = paletteColorJump(*palettePtr);
-      tries++;
+  void getRandomPalette(T* palettePtr, uint8_t minBrightness=0, uint8_t maxColorJump=0xFF, bool wrapped=false) {
+    if (!hasTraits) {
+      measurePalettes(palettePtr);
+    }
+    if (!hasEligible || minBrightness != eligibleMinBrightness || maxColorJump != eligibleMaxColorJump || wrapped != eligibleWrapped) {
+      findEligible(minBrightness, maxColorJump, wrapped);
     }
-    logf("  Picked Palette %u, %i tries", choice, tries);
+
+    assert(eligibleCount > 0, "No palettes of acceptable brightness & color continuity");
+    unsigned choice = (eligibleCount > 0 ? eligible[random16(eligibleCount)] : random16(gGradientPaletteCount));
+    *palettePtr = gGradientPalettes[choice];
+    logf("  Picked Palette %u, %u eligible", choice, eligibleCount);
   }
 };
 
@@ -642,41 +675,122 @@ PaletteManager<CRGBPalette16> paletteManager;
 
 /* -------------------------------------------------------------------- */
 
-void nblendPaletteTowardPalette(CRGBPalette256& current, CRGBPalette256& target, uint16_t maxChanges)
-{
-  uint8_t* p1;
-  uint8_t* p2;
-  uint16_t  changes = 0;
-
-  p1 = (uint8_t*)current.entries;
-  p2 = (uint8_t*)target.entries;
+// Steps a palette toward a target a bounded number of bytes per call, picking up
+// where the previous call stopped. Each byte moves up by one or down by up to
+// two per visit, like FastLED's nblendPaletteTowardPalette, but bytes that have
+// reached the target are dropped from the range that gets walked, and once the
+// palettes match there's nothing left to do.
+//
+// 32-bit boards step four bytes at a time in a uint32_t; AVR goes byte by byte.
+class PaletteBlender {
+public:
+  // Start blending every byte of a palette of `size` bytes (a multiple of 4)
+  void reset(uint16_t size) {
+    _start = _cursor = 0;
+    _end = size;
+    _nextStart = 0xFFFF;
+    _nextEnd = 0;
+  }
 
-  const uint16_t totalChannels = sizeof(CRGBPalette256);
-  for( uint16_t i = 0; i < totalChannels; i++) {
-    // if the values are equal, no changes are needed
-    if( p1[i] == p2[i] ) { continue; }
+  bool isDone() {
+    return _start >= _end;
+  }
 
-    // if the current value is less than the target, increase it by one
-    if( p1[i] < p2[i] ) { p1[i]++; changes++; }
+  // Visit at most `budget` bytes, stopping at the end of a pass. Returns true
+  // once current matches target.
+  bool step(uint8_t *current, const uint8_t *target, uint16_t budget) {
+    while (budget > 0 && _start < _end) {
+      if (stepUnit(current + _cursor, target + _cursor)) {
+        _nextStart = min(_nextStart, _cursor);
+        _nextEnd = _cursor + kStride;
+      }
+      _cursor += kStride;
+      budget = (budget > kStride ? budget - kStride : 0);
+
+      if (_cursor >= _end) {
+        // End of a pass: only what still differed needs another one
+        _start = _cursor = _nextStart;
+        _end = _nextEnd;
+        _nextStart = 0xFFFF;
+        _nextEnd = 0;
+        break; // at most one step per byte per call keeps the fade rate steady
+      }
+    }
+    return isDone();
+  }
 
-    // if the current value is greater than the target,
-    // increase it by one (or two if it's still greater).
-    if( p1[i] > p2[i] ) {
-        p1[i]--; changes++;
-        if( p1[i] > p2[i] ) { p1[i]--; }
+private:
+#if MEGA
+  static const uint8_t kStride = 1;
+
+  static bool stepUnit(uint8_t *current, const uint8_t *target) {
+    uint8_t c = *current;
+    const uint8_t t = *target;
+    if (c < t) {
+      ++c;
+    } else if (c > t) {
+      c -= (c - t >= 2 ? 2 : 1);
     }
+    *current = c;
+    return c != t;
+  }
+#else
+  static const uint8_t kStride = 4;
+
+  // One step for four bytes at once. Bytes are split into two sets of 16-bit
+  // lanes so per-byte differences can't borrow into their neighbours.
+  static uint32_t stepLanes(uint32_t c, uint32_t t) {
+    const uint32_t x = (c + 0x01000100) - t; // 0x100 + c - t per lane
+    const uint32_t up = (~x >> 8) & 0x00010001; // c < t
+    const uint32_t atLeast = ((x >> 8) & 0x00010001) * 0xFF; // c >= t, as a byte mask
+    const uint32_t d = x & atLeast; // c - t where c >= t
+    const uint32_t twoMask = (((d + 0x00FE00FE) >> 8) & 0x00010001) * 0xFF; // c - t >= 2
+    const uint32_t down = (twoMask & 0x00020002) | (~twoMask & d);
+    return c + up - down;
+  }
 
-    // if we've hit the maximum number of changes, exit
-    if( changes >= maxChanges) { break; }
+  static bool stepUnit(uint8_t *current, const uint8_t *target) {
+    // Palette entries are 3-byte structs, so these words may be unaligned
+    uint32_t c, t;
+    memcpy(&c, current, 4);
+    memcpy(&t, target, 4);
+    if (c == t) {
+      return false;
+    }
+    c = stepLanes(c & 0x00FF00FF, t & 0x00FF00FF) | (stepLanes((c >> 8) & 0x00FF00FF, (t >> 8) & 0x00FF00FF) << 8);
+    memcpy(current, &c, 4);
+    return c != t;
   }
+#endif
+
+  uint16_t _start = 0, _end = 0; // bytes that may still differ
+  uint16_t _cursor = 0;
+  uint16_t _nextStart = 0xFFFF, _nextEnd = 0; // bytes found still differing this pass
+};
+
+// Palette lookup without blending between entries when the palette already
+// has one for every index
+static inline CRGB paletteEntry(const CRGBPalette256& palette, uint8_t n) {
+  return palette.entries[n];
 }
 
+static inline CRGB paletteEntry(const CRGBPalette16& palette, uint8_t n) {
+  return ColorFromPalette(palette, n);
+}
+
+// Crossfades through random palettes. tick() advances it once per frame, so
+// lookups in between all see the same palette and cost only a table read.
+// Blend steps are left for idle(), between frames, unless there hasn't been
+// any idle time for a while.
 template <class T>
 class PaletteRotation {
 private:
   PaletteManager<T> manager;
   T currentPalette;
   T targetPalette;
+  PaletteBlender blender;
+  unsigned long lastBlendMillis;
+  unsigned long lastPaletteMillis;
   uint8_t *colorIndexes = NULL;
   uint8_t colorIndexCount = 0;
 
@@ -684,37 +798,66 @@ private:
     manager.getRandomPalette(palettePr, minBrightness, maxColorJump);
   }
 
+  static const unsigned long kBlendIntervalMillis = 40;
+
+  void blendStep(unsigned long now) {
+    lastBlendMillis = now;
+    if (!blender.isDone()) {
+      blender.step((uint8_t *)currentPalette.entries, (const uint8_t *)targetPalette.entries, blendBudget);
+    }
+  }
+
 public:
   int secondsPerPalette = 10;
   uint8_t minBrightness = 0;
   uint8_t maxColorJump = 0xFF;
+  // Bytes of the palette stepped toward the target every kBlendIntervalMillis,
+  // the third of it nblendPaletteTowardPalette used to change per step
+  uint16_t blendBudget = sizeof(T) / 3;
   
   PaletteRotation(int minBrightness=0) {
     this->minBrightness = minBrightness;
     assignPalette(&currentPalette);
     assignPalette(&targetPalette);
+    blender.reset(sizeof(T));
+    lastBlendMillis = lastPaletteMillis = millis();
   }
 
   ~PaletteRotation() {
     delete [] colorIndexes;
   }
   
-  void tick() {
-    EVERY_N_MILLISECONDS(40) {
-      nblendPaletteTowardPalette(currentPalette, targetPalette, sizeof(T) / 3);
+  // Advance palette changes to `now` (wall time, in millis)
+  void tick(unsigned long now) {
+    if (now - lastBlendMillis >= 2 * kBlendIntervalMillis) {
+      // Frames are leaving no idle time, so blending has to happen here
+      blendStep(now);
     }
-    EVERY_N_SECONDS(secondsPerPalette) {
+    if (now - lastPaletteMillis >= secondsPerPalette * 1000UL) {
+      lastPaletteMillis = now;
       assignPalette(&targetPalette);
+      blender.reset(sizeof(T));
     }
   }
 
-  T& getPalette() {
-    tick();
+  // A blend step is due and has something to blend, for idle() to take
+  bool blendDue(unsigned long now) {
+    return !blender.isDone() && now - lastBlendMillis >= kBlendIntervalMillis;
+  }
+
+  // Take the next blend step if it's due. Between frames only.
+  void idle(unsigned long now) {
+    if (now - lastBlendMillis >= kBlendIntervalMillis) {
+      blendStep(now);
+    }
+  }
+
+  const T& getPalette() {
     return currentPalette;
   }
 
   CRGB getPaletteColor(uint8_t n) {
-    return ColorFromPalette(getPalette(), n);
+    return paletteEntry(currentPalette, n);
   }
 
   CRGB getTrackedColor(uint8_t n) {
@@ -722,11 +865,10 @@ public:
     if (n >= colorIndexCount) {
       return CRGB::Black;
     }
-    T& palette = getPalette();
-    CRGB color = ColorFromPalette(palette, colorIndexes[n]);
+    CRGB color = paletteEntry(currentPalette, colorIndexes[n]);
     while (linearBrightness(color) < minBrightness) {
       colorIndexes[n] = addmod8(colorIndexes[n], 1, 0xFF);
-      color = ColorFromPalette(palette, colorIndexes[n]);
+      color = paletteEntry(currentPalette, colorIndexes[n]);
     }
     return color;
   }
@@ -756,3 +898,5 @@ public:
     }
   }
 };
+
+#endif // PALETTES_H
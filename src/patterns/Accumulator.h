@@ -0,0 +1,75 @@
+#ifndef PATTERNS_ACCUMULATOR_H
+#define PATTERNS_ACCUMULATOR_H
+
+#include "../Pattern.h"
+#include "../Blur.h"
+
+// Pings of color land at random and blur out into their neighbors
+class AccumulatorPattern : public Pattern {
+public:
+  void begin(PatternContext& ctx) {
+    _blur.begin(ctx.arena, ctx.lightCount, kBlurWidth, kBlurDecay, kBlurThreshold);
+    _lastBlur = ctx.clock.now(); // blurs start owing from here, not from boot
+    _usesPalette = ctx.random.below(2); // palettize sometimes
+    ctx.palette.secondsPerPalette = 20;
+  }
+
+  void tick(PatternContext& ctx) {
+    const unsigned int lightCount = ctx.lightCount;
+    const unsigned long time = ctx.clock.now();
+
+    // Animation time already runs at the global speed
+    const unsigned int kPingInterval = 30000 / lightCount;
+    const unsigned int kBlurInterval = 50; // for a whole pass
+    if (time - _lastPing > kPingInterval) {
+      unsigned int ping = ctx.random.below(lightCount);
+      Color c = kBlackColor;
+      if (_usesPalette) {
+        c = Color(ctx.palette.getPaletteColor(ctx.random.below(0x100)));
+      } else {
+        c = NamedRainbow.randomColor(ctx.random);
+      }
+
+      for (unsigned int i = (ping - 1); i <= ping + 1; ++i) {
+        unsigned int light = (i + lightCount) % lightCount;
+        ctx.transitions.transitionToColor(light, c, 250, LightTransitionEaseInOut);
+      }
+
+      _lastPing = time;
+    }
+
+    // Each frame blurs its share of a pass, rather than every light at once
+    // every kBlurInterval
+    _blurDue += (time - _lastBlur) * lightCount;
+    _lastBlur = time;
+    unsigned int blurCount = min(_blurDue / kBlurInterval, (unsigned long)lightCount);
+    _blurDue -= blurCount * kBlurInterval;
+    if (blurCount == lightCount) {
+      _blurDue = 0; // don't bank up a backlog after a long frame
+    }
+    while (blurCount--) {
+      unsigned int target;
+      Color c = _blur.next(ctx.lights.color, target);
+      if (!ctx.transitions.isTransitioning(target)) {
+        ctx.transitions.transitionToColor(target, c, 200);
+      }
+    }
+  }
+
+  static size_t arenaBytes(unsigned int lightCount) {
+    return Blur::arenaBytes(kBlurWidth);
+  }
+
+private:
+  static const uint8_t kBlurWidth = 1;
+  static const uint8_t kBlurDecay = 235; // about 0.92 a pass
+  static const uint8_t kBlurThreshold = 20; // dimmer lights don't spread
+
+  Blur _blur;
+  bool _usesPalette;
+  unsigned long _lastPing = 0;
+  unsigned long _lastBlur = 0;
+  unsigned long _blurDue = 0; // lights owed a blur, times kBlurInterval
+};
+
+#endif // PATTERNS_ACCUMULATOR_H
@@ -0,0 +1,18 @@
+#ifndef PATTERNS_BOOMRESPONDER_H
+#define PATTERNS_BOOMRESPONDER_H
+
+#include "../Pattern.h"
+
+// Meant to react to sound someday. For now every idle light fades to a random color.
+class BoomResponderPattern : public Pattern {
+public:
+  void tick(PatternContext& ctx) {
+    for (unsigned int i = 0; i < ctx.lightCount; ++i) {
+      if (!ctx.transitions.isTransitioning(i)) {
+        ctx.transitions.transitionToColor(i, NamedRainbow.randomColor(ctx.random), 1000);
+      }
+    }
+  }
+};
+
+#endif // PATTERNS_BOOMRESPONDER_H
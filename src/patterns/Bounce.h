@@ -0,0 +1,25 @@
+#ifndef PATTERNS_BOUNCE_H
+#define PATTERNS_BOUNCE_H
+
+#include "../Pattern.h"
+
+// A single light running end to end, leaving a fading trail
+class BouncePattern : public Pattern {
+public:
+  void tick(PatternContext& ctx) {
+    Follower& follow = ctx.follow;
+    ctx.transitions.transitionToColor((int)follow.leader, kBlackColor, 400);
+    follow.leader = follow.leader + _direction;
+    // The follow leader also drifts on its own each tick, so clamp rather than test for exact endpoints
+    if (follow.leader >= ctx.lightCount - 1 || follow.leader <= 0) {
+      follow.leader = (follow.leader <= 0 ? 0 : ctx.lightCount - 1);
+      _direction = -_direction;
+    }
+    ctx.lights.setColor((int)follow.leader, RGBRainbow.randomColor(ctx.random));
+  }
+
+private:
+  int _direction = 1;
+};
+
+#endif // PATTERNS_BOUNCE_H
@@ -0,0 +1,82 @@
+#ifndef PATTERNS_FIRE_H
+#define PATTERNS_FIRE_H
+
+#include "../Pattern.h"
+
+static const Color kFireColors[] = {MakeColor(0xFF, 0x3C, 0), MakeColor(0xFF, 0x80, 0), MakeColor(0xDD, 0x60, 0x02)};
+static const Color kBlueFireColors[] = {MakeColor(0x30, 0x10, 0xFF), MakeColor(0, 0xB0, 0xFF), MakeColor(0x1, 0xC0, 0xC0)};
+static const Color kGreenFireColors[] = {MakeColor(0x10, 0xFF, 0x0), MakeColor(0xA0, 0xFF, 0x0), MakeColor(0x0B, 0x66, 0x13)};
+static const Color kPinkFireColors[] = {MakeColor(0xFF, 0x0, 0xFF), MakeColor(0xBF, 0x0, 0xFF), MakeColor(0xF8, 0x18, 0x94)};
+
+// Interpolate, fade, and snap between three colors.
+//
+// Every light is always busy with a fade, and only acts as its fade ends, so
+// the lights to visit are exactly the transition engine's finished ones rather
+// than the whole strand, except on frames after ones this pattern missed.
+class FirePattern : public Pattern {
+public:
+  FirePattern(const Color *colors=kFireColors) : _colors(colors) {}
+
+  void tick(PatternContext& ctx) {
+    // On the first frame, or after frames the scene didn't tick us for, lights
+    // went idle that the last tick's finished bits don't show
+    const bool missedTicks = (ctx.transitions.tickCount() != _seenTick + 1);
+    _seenTick = ctx.transitions.tickCount();
+    if (missedTicks) {
+      for (unsigned int i = 0; i < ctx.lightCount; ++i) {
+        if (!ctx.transitions.isTransitioning(i)) {
+          flicker(ctx, i);
+        }
+      }
+      return;
+    }
+    TransitionEngine& transitions = ctx.transitions;
+    for (unsigned int i = transitions.nextFinished(0); i < ctx.lightCount; i = transitions.nextFinished(i + 1)) {
+      if (!transitions.isTransitioning(i)) {
+        flicker(ctx, i);
+      }
+    }
+  }
+
+private:
+  static const unsigned int kColorCount = 3;
+  const Color *_colors;
+  unsigned long _seenTick = -1; // the transition tick this pattern last ran after
+
+  void flicker(PatternContext& ctx, unsigned int i) {
+    long choice = ctx.random.below(100);
+
+    if (choice < 10) {
+      // 10% of the time, fade slowly to black
+      ctx.transitions.transitionToColor(i, kBlackColor, 500);
+    } else {
+      // Otherwise, fade or snap to another color
+      Color new_color = _colors[ctx.random.below(kColorCount)];
+      if (choice < 95) {
+        Color mixedColor = ColorWithInterpolatedColors(ctx.lights.color[i], new_color, ctx.random.below(0x100), ctx.random.below(0x100));
+        ctx.transitions.transitionToColor(i, mixedColor, 240);
+      } else {
+        ctx.lights.setColor(i, new_color);
+        // after setting the color, do a fade to this same color to keep the light "busy" for a short time.
+        ctx.transitions.transitionToColor(i, new_color, 100);
+      }
+    }
+  }
+};
+
+class BlueFirePattern : public FirePattern {
+public:
+  BlueFirePattern() : FirePattern(kBlueFireColors) {}
+};
+
+class GreenFirePattern : public FirePattern {
+public:
+  GreenFirePattern() : FirePattern(kGreenFireColors) {}
+};
+
+class PinkFirePattern : public FirePattern {
+public:
+  PinkFirePattern() : FirePattern(kPinkFireColors) {}
+};
+
+#endif // PATTERNS_FIRE_H
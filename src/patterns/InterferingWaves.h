@@ -0,0 +1,117 @@
+#ifndef PATTERNS_INTERFERINGWAVES_H
+#define PATTERNS_INTERFERINGWAVES_H
+
+#include "../Pattern.h"
+
+// Colored waves traveling both ways around the strand, blending where they
+// cross. Fades in from whatever the previous mode left over its first seconds.
+//
+// Positions are 8.8 fixed point, in lights. Each wave blends itself into the
+// scratch strand over the lights it covers, and one pass at the end eases the
+// scratch onto the strand and clears it for the next frame, so a frame costs
+// the waves' spans plus one visit per light.
+class InterferingWavesPattern : public Pattern {
+public:
+  void begin(PatternContext& ctx) {
+    _waveCount = waveCount(ctx.lightCount);
+    _variation = ctx.arena.alloc<int8_t>(_waveCount);
+    ctx.random.fill((uint8_t *)_variation, _waveCount);
+    for (unsigned int i = 0; i < _waveCount; ++i) {
+      _variation[i] = ((uint8_t)_variation[i] * 80 >> 8) - 40;
+    }
+    ctx.colorMaker.prepColors(ctx.arena, _waveCount, 5000, ctx.clock.now(), ctx.random);
+    _colorScratch = ctx.arena.alloc<Color>(ctx.lightCount);
+    for (unsigned int i = 0; i < ctx.lightCount; ++i) {
+      _colorScratch[i] = kBlackColor;
+    }
+  }
+
+  void tick(PatternContext& ctx) {
+    const int halfWave = kWaveLength / 2;
+    const int32_t halfWaveFixed = (int32_t)halfWave << 8;
+    const unsigned int lightCount = ctx.lightCount;
+    const int32_t strandFixed = (int32_t)lightCount << 8;
+
+    const int32_t followFixed = ctx.follow.leader * 256;
+    const int32_t chunkFixed = strandFixed / _waveCount;
+    const unsigned int forwardCount = (_waveCount + 1) / 2; // half the colors going in each direction
+    for (unsigned int waveIndex = 0; waveIndex < _waveCount; ++waveIndex) {
+      int32_t leader;
+      if (waveIndex < forwardCount) {
+        leader = followFixed + 2 * (int32_t)waveIndex * chunkFixed;
+      } else {
+        leader = strandFixed - (followFixed + 2 * (int32_t)(waveIndex - forwardCount) * chunkFixed + chunkFixed);
+      }
+      leader += _variation[waveIndex] * 64; // variation is in quarter lights
+      leader %= strandFixed;
+      if (leader < 0) {
+        leader += strandFixed;
+      }
+
+      const Color waveColor = ctx.colorMaker.getColor(waveIndex);
+      const int32_t first = (leader >> 8) - halfWave;
+      unsigned int lightIndex = (first % (int32_t)lightCount + lightCount) % lightCount;
+      for (int32_t p = first; p < first + kWaveLength; ++p) {
+        int32_t distance = abs(p * 256 - leader);
+        if (distance > strandFixed / 2) {
+          distance = strandFixed - distance; // around the end of a short strand
+        }
+        if (distance < halfWaveFixed) {
+          Color& existingColor = _colorScratch[lightIndex];
+
+          uint8_t litRatio = (existingColor.red + existingColor.green + existingColor.blue) / 3;
+          // If the existing light is less than about 3% lit, use the whole new color. Otherwise smoothly fade into splitting the difference.
+          const uint8_t minLit = 0xFF * 3 / 100;
+          const uint8_t normLit = 0xFF / 10;
+          uint8_t additionalFade = (litRatio < minLit ? 0x7F : (litRatio > normLit ? 0 : (0x7F - 0x7F * litRatio / normLit)));
+
+          uint8_t fadeProgress = (halfWaveFixed - distance) * (0x7F + additionalFade) / halfWaveFixed;
+          existingColor = ColorWithInterpolatedColors(existingColor, waveColor, fadeProgress, 0xFF);
+        }
+        if (++lightIndex == lightCount) {
+          lightIndex = 0;
+        }
+      }
+    }
+
+    // For the first 3 seconds of interfering waves, fade from previous mode
+    static const int kFadeTime = 3000;
+    unsigned long modeTime = ctx.modeTime();
+    const bool inModeTransition = modeTime < kFadeTime;
+    const uint8_t modeFade = (inModeTransition ? 0xFF * modeTime / kFadeTime : 0xFF);
+
+    // Ease every light, black where no wave reached, and clear the scratch
+    const uint8_t *ease = kTransitionCurveTables[LightTransitionEaseInOut - 1];
+    for (unsigned int i = 0; i < lightCount; ++i) {
+      Color color = _colorScratch[i];
+      color.red = pgm_read_byte(ease + color.red);
+      color.green = pgm_read_byte(ease + color.green);
+      color.blue = pgm_read_byte(ease + color.blue);
+      if (inModeTransition) {
+        color = ColorWithInterpolatedColors(ctx.lights.color[i], color, modeFade, 0xFF);
+      }
+      ctx.lights.setColor(i, color);
+      _colorScratch[i] = kBlackColor;
+    }
+  }
+
+  // The scratch strand, and each wave's speed variation and color
+  static size_t arenaBytes(unsigned int lightCount) {
+    const unsigned int count = waveCount(lightCount);
+    return Arena::bytes<Color>(lightCount) + Arena::bytes<int8_t>(count) + ColorMaker::arenaBytes(count);
+  }
+
+private:
+  static const int kWaveLength = 18;
+  static const unsigned int kLightsPerWave = 20;
+
+  unsigned int _waveCount;
+  int8_t *_variation; // per-wave offset from the follow leader, in quarter lights
+  Color *_colorScratch; // the waves without easing or the fade in
+
+  static unsigned int waveCount(unsigned int lightCount) {
+    return max(lightCount / kLightsPerWave, 1u);
+  }
+};
+
+#endif // PATTERNS_INTERFERINGWAVES_H
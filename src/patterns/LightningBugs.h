@@ -0,0 +1,74 @@
+#ifndef PATTERNS_LIGHTNINGBUGS_H
+#define PATTERNS_LIGHTNINGBUGS_H
+
+#include "../Pattern.h"
+#include "../EventSampler.h"
+
+// Yellow-green blinks over a night sky. Each light's modeState walks
+// 0 (sky) -> 1 (lit) -> 2 (going out) -> 0.
+class LightningBugsPattern : public Pattern {
+public:
+  void begin(PatternContext& ctx) {
+    ctx.transitionAll(kNightColor, 1200);
+  }
+
+  void tick(PatternContext& ctx) {
+    // Bugs that finished a step of their blink take the next one. After frames
+    // the scene didn't tick us for, what finished in those isn't marked any
+    // more, so look over every bug.
+    const bool missedTicks = (ctx.transitions.tickCount() != _seenTick + 1);
+    _seenTick = ctx.transitions.tickCount();
+    if (missedTicks) {
+      for (unsigned int i = 0; i < ctx.lightCount; ++i) {
+        stepBlink(ctx, i);
+      }
+    } else {
+      TransitionEngine& transitions = ctx.transitions;
+      for (unsigned int i = transitions.nextFinished(0); i < ctx.lightCount; i = transitions.nextFinished(i + 1)) {
+        stepBlink(ctx, i);
+      }
+    }
+
+    // cycle the lightning bugs density over a minute
+    unsigned int chance = 1400 + 1000 * sin(M_PI * ctx.clock.realNow() / 1000 / 60);
+    // Every light has its 1 in chance each frame, but only the lucky ones are
+    // visited. Those that are busy blinking or still fading in let it pass.
+    _blinks.setChance(chance, ctx.random);
+    unsigned int i;
+    while (_blinks.next(ctx.lightCount, i, ctx.random)) {
+      if (!ctx.transitions.isTransitioning(i) && ctx.lights.modeState[i] == 0) {
+        // Blinky blinky
+        ctx.transitions.transitionToColor(i, MakeColor(0xD0, 0xFF, 0), 350, LightTransitionLinear, true);
+        ctx.lights.modeState[i] = 1;
+      }
+    }
+  }
+
+  void end(PatternContext& ctx) {
+    // Have all the bugs go out
+    ctx.transitionAll(kNightColor, 1000);
+  }
+
+private:
+  EventSampler _blinks;
+  unsigned long _seenTick = -1; // the transition tick this pattern last ran after
+
+  void stepBlink(PatternContext& ctx, unsigned int i) {
+    if (ctx.transitions.isTransitioning(i)) {
+      return;
+    }
+    switch (ctx.lights.modeState[i]) {
+      case 1:
+        // When putting a bug out, fade to black first, otherwise we fade from yellow(ish) to blue and go through white.
+        ctx.transitions.transitionToColor(i, kBlackColor, 450, LightTransitionEaseInOut, true);
+        ctx.lights.modeState[i] = 2;
+        break;
+      case 2:
+        ctx.transitions.transitionToColor(i, kNightColor, 450, LightTransitionLinear, true);
+        ctx.lights.modeState[i] = 0;
+        break;
+    }
+  }
+};
+
+#endif // PATTERNS_LIGHTNINGBUGS_H
@@ -0,0 +1,39 @@
+#ifndef PATTERNS_PARITY_H
+#define PATTERNS_PARITY_H
+
+#include "../Pattern.h"
+
+// Odd and even lights sweep the palette in opposite directions
+class ParityPattern : public Pattern {
+public:
+  void begin(PatternContext& ctx) {
+    ctx.palette.secondsPerPalette = 8;
+    ctx.palette.maxColorJump = 10;
+    ctx.follow.speed = 12;
+  }
+
+  void tick(PatternContext& ctx) {
+    const int paletteRange = min(50u, ctx.lightCount / 2);
+    const int parityCount = 2;
+    for (int i = 0; i < (int)ctx.lightCount; ++i) {
+      if (!ctx.transitions.isTransitioning(i)) { // serves to not interrupt existing fades when this pattern starts
+        int parity = i % parityCount;
+        int paletteIndex = map(i + (parity ? paletteRange - ctx.follow.leader : ctx.follow.leader), 0, paletteRange, 0, 0x100);
+
+        // to avoid palette discontinuities at the endpoints, "bounce" the palette so read up to 0xFF then back down to 0, then back up.
+        paletteIndex = mod_wrap(paletteIndex, 0x200);
+        if (paletteIndex > 0xFF) {
+          paletteIndex = 0x1FF - paletteIndex;
+        }
+
+        Color targetColor = Color(ctx.palette.getPaletteColor(paletteIndex));
+
+        long modeTime = ctx.modeTime();
+        long fadeTime = max(100, (2000 - modeTime) / 5);
+        ctx.transitions.transitionToColor(i, targetColor, fadeTime);
+      }
+    }
+  }
+};
+
+#endif // PATTERNS_PARITY_H
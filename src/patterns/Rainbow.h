@@ -0,0 +1,35 @@
+#ifndef PATTERNS_RAINBOW_H
+#define PATTERNS_RAINBOW_H
+
+#include "../Pattern.h"
+
+// ROYGBIV bands chasing the follow leader
+class RainbowPattern : public Pattern {
+public:
+  void begin(PatternContext& ctx) {
+    _firstColorIndex = ctx.random.below(ROYGBIVRainbow.count);
+  }
+
+  void tick(PatternContext& ctx) {
+    const unsigned int waveLength = 7;
+    const int fadeDuration = 1000 * (waveLength - 2) / ctx.follow.speed * 0.9;
+
+    unsigned int colorIndex = _firstColorIndex;
+    for (unsigned int i = 0; i < ctx.lightCount / waveLength; ++i) {
+      unsigned int changeIndex = ((int)ctx.follow.leader + i * waveLength) % ctx.lightCount;
+      Color waveColor = ROYGBIVRainbow.getColor(ROYGBIVRainbow.indexForColor(colorIndex));
+      waveColor = ColorWithInterpolatedColors(waveColor, kBlackColor, 0, 0xB0); // dim a little
+      if (++colorIndex == ROYGBIVRainbow.count) {
+        colorIndex = 0;
+      }
+      if (!ctx.transitions.isTransitioning(changeIndex)) {
+        ctx.transitions.transitionToColor(changeIndex, waveColor, fadeDuration, LightTransitionEaseInOut);
+      }
+    }
+  }
+
+private:
+  unsigned int _firstColorIndex;
+};
+
+#endif // PATTERNS_RAINBOW_H
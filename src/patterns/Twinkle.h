@@ -0,0 +1,81 @@
+#ifndef PATTERNS_TWINKLE_H
+#define PATTERNS_TWINKLE_H
+
+#include "../Pattern.h"
+
+static const Color kTwinkleRainbow[] = {kRedColor, kOrangeColor, kYellowColor, kGreenColor, kCyanColor, kBlueColor, kMagentaColor, kVioletColor, kBlackColor, kBlackColor};
+
+// The strand split into interleaved segments, two of which change color
+// whenever everything settles
+class TwinklePattern : public Pattern {
+public:
+  void begin(PatternContext& ctx) {
+    for (unsigned i = 0; i < ctx.lightCount; ++i) {
+      Color color = ROYGBIVRainbow.randomColor(ctx.random);
+      ctx.transitions.transitionToColor(i, color, 1000);
+    }
+  }
+
+  // Only acts once everything has settled
+  unsigned int framesPerSecond() {
+    return 60;
+  }
+
+  void tick(PatternContext& ctx) {
+    if (ctx.transitions.activeCount() > 0) {
+      return;
+    }
+    for (int twice = 0; twice < 2; ++twice) {
+      int changeSegment;
+      do {
+        changeSegment = ctx.random.below(kSegments);
+      } while (changeSegment == _lastSegmentChanged);
+      _lastSegmentChanged = changeSegment;
+
+      Color startColor = ctx.lights.color[changeSegment];
+      Color targetColor;
+
+      // Black is a possible target, so make sure we don't transition to a completely black strand
+      bool acceptableColor = false;
+      do {
+        targetColor = kTwinkleRainbow[ctx.random.below(ARRAY_SIZE(kTwinkleRainbow))];
+
+        if (ColorIsEqualToColor(startColor, targetColor)) {
+          // Actually change the color
+          continue;
+        }
+        if (ColorTransitionWillProduceWhite(startColor, targetColor)) {
+          // Don't fade through white
+          continue;
+        }
+
+        bool targetIsBlackColor = ColorIsEqualToColor(targetColor, kBlackColor);
+        if (targetIsBlackColor) {
+          bool transitioningToAllBlack = true;
+          for (int seg = 0; seg < kSegments; ++seg) {
+            Color segColor = (ctx.transitions.isTransitioning(seg) ? ctx.transitions.targetColor[seg] : ctx.lights.color[seg]);
+            if (seg != changeSegment && !ColorIsEqualToColor(segColor, kBlackColor)) {
+              transitioningToAllBlack = false;
+              break;
+            }
+          }
+          if (transitioningToAllBlack) {
+            // who turned out the lights?
+            continue;
+          }
+        }
+        acceptableColor = true;
+      } while (!acceptableColor);
+
+      for (unsigned i = changeSegment; i < ctx.lightCount; i += kSegments) {
+        ctx.transitions.transitionToColor(i, targetColor, 1000);
+      }
+    }
+  }
+
+private:
+  static const int kSegments = 5;
+  int _lastSegmentChanged = -1;
+};
+
+#endif // PATTERNS_TWINKLE_H
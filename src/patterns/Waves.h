@@ -0,0 +1,55 @@
+#ifndef PATTERNS_WAVES_H
+#define PATTERNS_WAVES_H
+
+#include "../Pattern.h"
+
+// Evenly spaced waves chasing the follow leader, in one changing color or
+// spread across the palette
+class WavesPattern : public Pattern {
+public:
+  void begin(PatternContext& ctx) {
+    unsigned int colorCount = ctx.random.below(2); // palettize half the time
+    logf("  Waves submode %s", colorCount == 1 ? "1 color" : "palette");
+    ctx.colorMaker.prepColors(ctx.arena, colorCount, 6000, ctx.clock.now(), ctx.random);
+
+    ctx.palette.secondsPerPalette = 20;
+    ctx.palette.minBrightness = 20;
+
+    _waveLength = (ctx.random.below(3) == 0 ? 50 : 20); // assumes number of lights is roughly divisible by 50
+  }
+
+  void tick(PatternContext& ctx) {
+    // Needs to fade out over less than half a wave, so there are some off in the middle.
+    const int fadeDuration = 1000 * (_waveLength / 2) / (ctx.follow.speed);
+
+    Color waveColor = kBlackColor;
+    if (ctx.colorMaker.getColorCount() > 0) {
+      waveColor = ctx.colorMaker.getColor(0);
+    }
+
+    unsigned int waveCount = ctx.lightCount / _waveLength;
+    for (unsigned int i = 0; i < waveCount; ++i) {
+      if (ctx.colorMaker.getColorCount() == 0) {
+        waveColor = Color(ctx.palette.getPaletteColor(0xFF * i / waveCount));
+      }
+      unsigned int turnOnLeaderIndex = ((int)ctx.follow.leader + i * _waveLength) % ctx.lightCount;
+      unsigned int turnOffLeaderIndex = ((int)ctx.follow.leader + i * _waveLength - _waveLength / 2 + ctx.lightCount) % ctx.lightCount;
+
+      if (!ctx.transitions.isTransitioning(turnOnLeaderIndex)) {
+        ctx.transitions.transitionToColor(turnOnLeaderIndex, waveColor, fadeDuration, LightTransitionEaseInOut);
+      }
+      if (!ctx.transitions.isTransitioning(turnOffLeaderIndex)) {
+        ctx.transitions.transitionToColor(turnOffLeaderIndex, kBlackColor, fadeDuration * 0.75, LightTransitionEaseInOut);
+      }
+    }
+  }
+
+  static size_t arenaBytes(unsigned int lightCount) {
+    return ColorMaker::arenaBytes(1);
+  }
+
+private:
+  unsigned int _waveLength;
+};
+
+#endif // PATTERNS_WAVES_H